@@ -0,0 +1,206 @@
+#ifndef backend_common_cpp
+#define backend_common_cpp
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gmpxx.h>
+
+#include "../engines/mask_kernels.cpp"
+#include "../engines/chunk_arena.cpp"
+#include "../engines/canonicalize.cpp"
+#include "../engines/residue_runner.cpp"
+#include "../engines/multi_query.cpp"
+#include "input_reader.cpp"
+
+// What the execution backends share: the options picked on the command line, reading the input,
+// writing the answer and summing one chunk of masks.
+//
+// A backend gets a runner for the canonical problem (a MaskKernelRunner, or a ResidueRunner which sums
+// into residues) and returns the Runner::Sum over the whole range [0, runner.rangeLimit()),
+// i.e. every mask in [0, 2^K) for the mask kernels; with MPI only the master's return value is the answer.
+
+const char * const INPUT_FILE = "suman.in";
+const char * const OUTPUT_FILE = "suman.out";
+const int MAX_RESERVED_DIVISORS = 1 << 20; // the vector grows past it as the divisors come in
+
+enum WorkListKind {
+    WORK_LIST_STACK,  // lock_free_stack
+    WORK_LIST_QUEUE,  // lock_free_queue
+};
+
+struct BackendOptions {
+    int debug;
+    int threads;            // for the threads backend
+    WorkListKind workList;  // for the threads backend
+    bool gmpArena;          // bigNumber only: chunks get their GMP memory from a per-thread bump arena
+    bool quotientBuckets;   // bigNumber only: the terms of a chunk are summed per quotient N / L, see quotient_buckets.cpp
+};
+
+
+// Reads N and the divisors from INPUT_FILE and drops the divisors which can't change the answer.
+// The divisors are read as they stream in, so their number is only limited by memory.
+// If maxN isn't NULL, it replaces the N of the input (for "--queries", the biggest N asked for), which then only
+// has to be a number, of any size.
+// Returns false (after saying why) if the input is missing or malformed.
+template<typename Number>
+bool readProblem(int debug, SubsetProblem<Number>& problem, const Number *maxN = NULL) {
+    NumberStreamReader in(INPUT_FILE);
+
+    int numDivisors = 0;
+    mpz_class replacedN;
+    if (maxN != NULL ? !in.read(replacedN) : (!in.read(problem.N) || problem.N < 0)) {
+        printf("Bad input in %s: N is missing, negative, out of range or not a number\n", INPUT_FILE);
+        return false;
+    }
+    if (!in.read(numDivisors) || numDivisors < 0) {
+        printf("Bad input in %s: the number of divisors is missing, negative, out of range or not a number\n", INPUT_FILE);
+        return false;
+    }
+    if (maxN != NULL) {
+        problem.N = *maxN;
+    }
+
+    // the count is only a hint until the divisors are actually there
+    problem.divisors.clear();
+    problem.divisors.reserve(std::min(numDivisors, MAX_RESERVED_DIVISORS));
+    Number d;
+    while ((int)problem.divisors.size() < numDivisors) {
+        if (!in.read(d) || d < 1) {
+            printf("Bad input in %s: expected %i divisors, but divisor #%i is missing, not positive, out of range or not a number\n",
+                   INPUT_FILE, numDivisors, (int)problem.divisors.size() + 1);
+            return false;
+        }
+        problem.divisors.push_back(d);
+    }
+
+    CanonicalizationReport report = canonicalizeDivisors(problem.N, problem.divisors);
+    if (debug >= 1) {
+        printf("%s\n", describeCanonicalization(report).c_str());
+    }
+
+    return true;
+}
+
+// Reads the queries of "--queries" from path, one per line: N, or A B for the interval [A, B].
+// Returns false if the file is missing or a line is something else.
+template<typename Number>
+bool readQueries(const char *path, std::vector<IntervalQuery<Number>>& queries) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::vector<Number> numbers;
+        Number number;
+        while (fields >> number) {
+            numbers.push_back(number);
+        }
+        if (!fields.eof() || numbers.size() > 2) {
+            return false;
+        }
+        if (numbers.empty()) {
+            continue;
+        }
+
+        IntervalQuery<Number> query;
+        query.low = (numbers.size() == 2) ? numbers[0] : Number(1);
+        query.high = numbers.back();
+        if (query.low < 1 || query.high < query.low - 1) {
+            return false;
+        }
+        queries.push_back(query);
+    }
+    return true;
+}
+
+template<typename Number>
+std::string numberToString(const Number& number) {
+    std::ostringstream stream;
+    stream << number;
+    return stream.str();
+}
+
+template<typename Number>
+void writeAnswer(const Number& totalSum) {
+    std::ofstream out(OUTPUT_FILE);
+    out << totalSum << '\n';
+    out.close();
+}
+
+// One line per query.
+template<typename Number>
+void writeAnswers(const std::vector<Number>& answers) {
+    std::ofstream out(OUTPUT_FILE);
+    for (const Number& answer : answers) {
+        out << answer << '\n';
+    }
+    out.close();
+}
+
+// The size of the chunks when [0, limit) is split into at most maxChunks of them.
+// When limit is a power of two (a range of masks), every chunk is an aligned block of masks.
+// Otherwise the last chunk may be shorter, see chunkEndFor.
+inline long long chunkSizeFor(long long limit, int maxChunks) {
+    if ((limit & (limit - 1)) != 0) {
+        return (limit + maxChunks - 1) / maxChunks;
+    }
+
+    long long numChunks = maxChunks;
+    while (limit % numChunks != 0) {
+        numChunks /= 2;
+    }
+    return limit / numChunks;
+}
+
+inline long long chunkEndFor(long long chunkStart, long long chunkSize, long long limit) {
+    return std::min(chunkStart + chunkSize, limit);
+}
+
+
+template<typename Runner>
+typename Runner::Sum sumChunk(const Runner& runner, const BackendOptions& options, long long chunkStart, long long chunkEnd) {
+    return runner.sumForRange(chunkStart, chunkEnd);
+}
+
+inline mpz_class sumChunkTerms(const MaskKernelRunner<mpz_class>& runner, const BackendOptions& options, long long chunkStart, long long chunkEnd) {
+    if (!options.quotientBuckets) {
+        return runner.sumForRange(chunkStart, chunkEnd);
+    }
+
+    size_t numBuckets;
+    mpz_class sum = sumInQuotientBuckets([&]() { return runner.sumForRange(chunkStart, chunkEnd); }, numBuckets);
+    if (options.debug >= 2) {
+        printf("Quotient buckets for mask interval [%lli,%lli): %zu\n", chunkStart, chunkEnd, numBuckets);
+    }
+    return sum;
+}
+
+inline mpz_class sumChunk(const MaskKernelRunner<mpz_class>& runner, const BackendOptions& options, long long chunkStart, long long chunkEnd) {
+    if (!options.gmpArena) {
+        return sumChunkTerms(runner, options, chunkStart, chunkEnd);
+    }
+
+    gmp_arena_stats stats;
+    mpz_class sum = sumInChunkArena([&]() { return sumChunkTerms(runner, options, chunkStart, chunkEnd); }, stats);
+    if (options.debug >= 2) {
+        printf("GMP memory for mask interval [%lli,%lli): %lld allocations (%lld bytes) in the arena, %lld (%lld bytes) on the heap\n",
+               chunkStart,
+               chunkEnd,
+               stats.arena_allocations,
+               stats.arena_bytes,
+               stats.heap_allocations,
+               stats.heap_bytes);
+    }
+    return sum;
+}
+
+
+#endif // backend_common_cpp
@@ -0,0 +1,134 @@
+#ifndef input_reader_cpp
+#define input_reader_cpp
+
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <gmpxx.h>
+
+// Reads whitespace-separated numbers from a file through a fixed-size buffer, so a divisor file of
+// any size is parsed in one pass without iostreams and without holding more than one block in memory.
+// long longs are parsed straight from the buffer; an mpz_class is collected as a token first.
+class NumberStreamReader {
+public:
+    explicit NumberStreamReader(const char *path):
+        file(fopen(path, "rb")),
+        position(0),
+        length(0) {
+
+    }
+
+    ~NumberStreamReader() {
+        if (file != NULL) {
+            fclose(file);
+        }
+    }
+
+    NumberStreamReader(const NumberStreamReader&) = delete;
+    NumberStreamReader& operator=(const NumberStreamReader&) = delete;
+
+    // Returns false if the file is missing, there's no number left, or the next token isn't a number in range.
+    bool read(long long& number) {
+        if (!skipWhitespace()) {
+            return false;
+        }
+
+        bool negative = false;
+        if (peek() == '-') {
+            negative = true;
+            advance();
+        }
+
+        // the digits are gathered as a magnitude, which can be 2^63 for LLONG_MIN
+        const unsigned long long limit = negative ? (unsigned long long)LLONG_MAX + 1 : (unsigned long long)LLONG_MAX;
+        unsigned long long magnitude = 0;
+        bool anyDigit = false, fits = true;
+        int c;
+        while ((c = peek()) != EOF && c >= '0' && c <= '9') {
+            const unsigned long long digit = c - '0';
+            if (magnitude > (limit - digit) / 10) {
+                fits = false;
+            }
+            else {
+                magnitude = magnitude * 10 + digit;
+            }
+            anyDigit = true;
+            advance();
+        }
+
+        if (!anyDigit || !fits || (c != EOF && !isWhitespace(c))) {
+            return false;
+        }
+        number = negative ? (long long)(0 - magnitude) : (long long)magnitude;
+        return true;
+    }
+
+    bool read(int& number) {
+        long long wide;
+        if (!read(wide) || wide < INT_MIN || wide > INT_MAX) {
+            return false;
+        }
+        number = (int)wide;
+        return true;
+    }
+
+    bool read(mpz_class& number) {
+        if (!skipWhitespace()) {
+            return false;
+        }
+
+        token.clear();
+        int c;
+        while ((c = peek()) != EOF && !isWhitespace(c)) {
+            token.push_back((char)c);
+            advance();
+        }
+        return number.set_str(token, 10) == 0;
+    }
+
+private:
+    static const int BUFFER_SIZE = 1 << 16;
+
+    FILE *file;
+    char buffer[BUFFER_SIZE];
+    int position;
+    int length;
+    std::string token;
+
+    static bool isWhitespace(int c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    // The next character, refilling the buffer when it's used up, or EOF.
+    int peek() {
+        if (position == length) {
+            if (file == NULL) {
+                return EOF;
+            }
+            length = (int)fread(buffer, 1, BUFFER_SIZE, file);
+            position = 0;
+            if (length == 0) {
+                return EOF;
+            }
+        }
+        return (unsigned char)buffer[position];
+    }
+
+    void advance() {
+        position += 1;
+    }
+
+    // Returns false if only whitespace is left.
+    bool skipWhitespace() {
+        int c;
+        while ((c = peek()) != EOF && isWhitespace(c)) {
+            advance();
+        }
+        return c != EOF;
+    }
+};
+
+
+#endif // input_reader_cpp
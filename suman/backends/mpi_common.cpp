@@ -0,0 +1,129 @@
+#ifndef mpi_common_cpp
+#define mpi_common_cpp
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gmpxx.h>
+#include <mpi.h>
+
+#include "backend_common.cpp"
+
+// What the two MPI backends share: logging and asserts tagged with the rank, getting the problem
+// from the master to every process, and moving numbers of either type through MPI.
+
+#define MPIPrintf(format, ...) printf("[%i]: " format, rank, ##__VA_ARGS__); fflush(stdout)
+
+inline void __MPIAssert(bool condition, const char * const cond_str, const char * const func, int line) {
+    if (!condition) {
+        printf("Assert condition [ %s ] failed at (%s):%i. Aborting...\n", cond_str, func, line);
+        fflush(stdout);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+}
+
+#define MPIAssert(condition) __MPIAssert((condition), #condition, __FUNCTION__, __LINE__)
+
+#define MASTER_RANK 0
+
+
+// A number as the bytes which go into an MPI message: a long long or a ResidueSum as itself,
+// an mpz_class as its decimal digits (so there's no limit on the size of the answer).
+inline std::string encodeNumber(long long number) {
+    return std::string((const char*)&number, sizeof(number));
+}
+
+inline void decodeNumber(const char *buffer, int bufferSize, long long& number) {
+    MPIAssert(bufferSize == (int)sizeof(number));
+    memcpy(&number, buffer, sizeof(number));
+}
+
+inline std::string encodeNumber(const ResidueSum& number) {
+    return std::string((const char*)&number, sizeof(number));
+}
+
+inline void decodeNumber(const char *buffer, int bufferSize, ResidueSum& number) {
+    MPIAssert(bufferSize == (int)sizeof(number));
+    memcpy(&number, buffer, sizeof(number));
+}
+
+inline std::string encodeNumber(const mpz_class& number) {
+    return number.get_str();
+}
+
+inline void decodeNumber(const char *buffer, int bufferSize, mpz_class& number) {
+    number = mpz_class(std::string(buffer, bufferSize));
+}
+
+template<typename Number>
+void broadcastNumber(int rank, Number& number) {
+    std::string buffer;
+    int bufferSize;
+    if (rank == MASTER_RANK) {
+        buffer = encodeNumber(number);
+        bufferSize = (int)buffer.size();
+    }
+
+    MPI_Bcast(&bufferSize, 1, MPI_INT, MASTER_RANK, MPI_COMM_WORLD);
+    buffer.resize(bufferSize);
+    MPI_Bcast(&buffer[0], bufferSize, MPI_CHAR, MASTER_RANK, MPI_COMM_WORLD);
+
+    if (rank != MASTER_RANK) {
+        decodeNumber(buffer.data(), bufferSize, number);
+    }
+}
+
+// All the numbers in three broadcasts (count, sizes, bytes) however many there are.
+template<typename Number>
+void broadcastNumbers(int rank, std::vector<Number>& numbers) {
+    int count = (int)numbers.size();
+    MPI_Bcast(&count, 1, MPI_INT, MASTER_RANK, MPI_COMM_WORLD);
+
+    std::vector<int> sizes(count);
+    std::string buffer;
+    if (rank == MASTER_RANK) {
+        for (int i = 0; i < count; ++i) {
+            std::string encoded = encodeNumber(numbers[i]);
+            sizes[i] = (int)encoded.size();
+            buffer += encoded;
+        }
+    }
+
+    MPI_Bcast(sizes.data(), count, MPI_INT, MASTER_RANK, MPI_COMM_WORLD);
+    int bufferSize = (int)buffer.size();
+    MPI_Bcast(&bufferSize, 1, MPI_INT, MASTER_RANK, MPI_COMM_WORLD);
+    buffer.resize(bufferSize);
+    MPI_Bcast(&buffer[0], bufferSize, MPI_CHAR, MASTER_RANK, MPI_COMM_WORLD);
+
+    if (rank != MASTER_RANK) {
+        numbers.resize(count);
+        int offset = 0;
+        for (int i = 0; i < count; ++i) {
+            decodeNumber(buffer.data() + offset, sizes[i], numbers[i]);
+            offset += sizes[i];
+        }
+    }
+}
+
+// The master reads (and canonicalizes) the problem, the others get it in broadcasts.
+template<typename Number>
+bool broadcastProblem(int rank, int debug, SubsetProblem<Number>& problem) {
+    int valid = 1;
+    if (rank == MASTER_RANK) {
+        valid = readProblem<Number>(debug, problem);
+    }
+    MPI_Bcast(&valid, 1, MPI_INT, MASTER_RANK, MPI_COMM_WORLD);
+    if (!valid) {
+        return false;
+    }
+
+    broadcastNumber(rank, problem.N);
+    broadcastNumbers(rank, problem.divisors);
+
+    return true;
+}
+
+
+#endif // mpi_common_cpp
@@ -0,0 +1,126 @@
+#ifndef mpi_dynamic_cpp
+#define mpi_dynamic_cpp
+
+#include "mpi_common.cpp"
+
+// The master hands out chunks of masks one at a time, giving a slave its next chunk as soon as
+// its last partial sum arrives, which helps when the nodes have unequal processing power.
+// The master only coordinates, so this needs at least two processes.
+
+const int DYNAMIC_NUM_CHUNKS = 16;
+
+enum MY_MPI_TAGS {
+    MY_MPI_TAGS_MASTER_TO_SLAVE_TASK,       // [chunkStart, chunkEnd) as two long longs
+    MY_MPI_TAGS_MASTER_TO_SLAVE_TERMINATE,
+    MY_MPI_TAGS_SLAVE_TO_MASTER_RESPONSE,   // the partial sum, as encodeNumber bytes
+};
+
+
+// Sends the next chunk to slaveRank, or tells it to stop if there's none left.
+// Returns false in the latter case.
+inline bool sendNextTask(int slaveRank, long long limit, long long chunkSize, long long& nextChunkStart) {
+    if (nextChunkStart < limit) {
+        long long task[2] = {nextChunkStart, chunkEndFor(nextChunkStart, chunkSize, limit)};
+        MPI_Send(task, 2, MPI_LONG_LONG_INT, slaveRank, MY_MPI_TAGS_MASTER_TO_SLAVE_TASK, MPI_COMM_WORLD);
+        nextChunkStart = task[1];
+        return true;
+    }
+    else {
+        // also happens right away when there are fewer chunks than slaves, e.g. after the divisors got canonicalized
+        char dummy = 0;
+        MPI_Send(&dummy, 1, MPI_CHAR, slaveRank, MY_MPI_TAGS_MASTER_TO_SLAVE_TERMINATE, MPI_COMM_WORLD);
+        return false;
+    }
+}
+
+template<typename Runner>
+typename Runner::Sum doMasterProc(int rank, int procNum, const Runner& runner, const BackendOptions& options) {
+    typedef typename Runner::Sum Sum;
+    const long long limit = runner.rangeLimit();
+    const long long chunkSize = chunkSizeFor(limit, DYNAMIC_NUM_CHUNKS);
+    if (options.debug >= 1) {
+        MPIPrintf("limit = %lli, chunkSize = %lli\n", limit, chunkSize);
+    }
+
+    long long nextChunkStart = 0;
+    int activeSlaves = 0;
+    for (int r = 0; r < procNum; ++r) {
+        if (r != MASTER_RANK && sendNextTask(r, limit, chunkSize, nextChunkStart)) {
+            activeSlaves += 1;
+        }
+    }
+
+    Sum totalSum = 0;
+    std::string buffer;
+    while (activeSlaves > 0) {
+        MPI_Status status;
+        MPI_Probe(MPI_ANY_SOURCE, MY_MPI_TAGS_SLAVE_TO_MASTER_RESPONSE, MPI_COMM_WORLD, &status);
+
+        int bufferSize;
+        MPI_Get_count(&status, MPI_CHAR, &bufferSize);
+        buffer.resize(bufferSize);
+        MPI_Recv(&buffer[0], bufferSize, MPI_CHAR, status.MPI_SOURCE, MY_MPI_TAGS_SLAVE_TO_MASTER_RESPONSE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+        Sum partialSum;
+        decodeNumber(buffer.data(), bufferSize, partialSum);
+        totalSum += partialSum;
+
+        if (!sendNextTask(status.MPI_SOURCE, limit, chunkSize, nextChunkStart)) {
+            if (options.debug >= 1) {
+                MPIPrintf("Rank %i finished\n", status.MPI_SOURCE);
+            }
+            activeSlaves -= 1;
+        }
+    }
+    MPIAssert(nextChunkStart == limit);
+
+    return totalSum;
+}
+
+template<typename Runner>
+void doSlaveProc(int rank, const Runner& runner, const BackendOptions& options) {
+    while (true) {
+        MPI_Status status;
+        MPI_Probe(MASTER_RANK, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+
+        if (status.MPI_TAG == MY_MPI_TAGS_MASTER_TO_SLAVE_TASK) {
+            long long task[2];
+            MPI_Recv(task, 2, MPI_LONG_LONG_INT, MASTER_RANK, MY_MPI_TAGS_MASTER_TO_SLAVE_TASK, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+            typename Runner::Sum localSum = sumChunk(runner, options, task[0], task[1]);
+            if (options.debug >= 2) {
+                MPIPrintf("Computed localSum for [%lli,%lli): %s\n", task[0], task[1], numberToString(localSum).c_str());
+            }
+
+            std::string buffer = encodeNumber(localSum);
+            MPI_Send(&buffer[0], (int)buffer.size(), MPI_CHAR, MASTER_RANK, MY_MPI_TAGS_SLAVE_TO_MASTER_RESPONSE, MPI_COMM_WORLD);
+        }
+        else {
+            MPIAssert(status.MPI_TAG == MY_MPI_TAGS_MASTER_TO_SLAVE_TERMINATE);
+
+            char dummy;
+            MPI_Recv(&dummy, 1, MPI_CHAR, MASTER_RANK, MY_MPI_TAGS_MASTER_TO_SLAVE_TERMINATE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            break;
+        }
+    }
+}
+
+// Only the master's return value is the answer; the slaves return 0.
+template<typename Runner, typename Number>
+typename Runner::Sum runMpiDynamic(const Runner& runner, const SubsetProblem<Number>& problem, const BackendOptions& options) {
+    int rank, procNum;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &procNum);
+    MPIAssert(procNum > 1);
+
+    if (rank == MASTER_RANK) {
+        return doMasterProc(rank, procNum, runner, options);
+    }
+    else {
+        doSlaveProc(rank, runner, options);
+        return 0;
+    }
+}
+
+
+#endif // mpi_dynamic_cpp
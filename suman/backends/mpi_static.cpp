@@ -0,0 +1,99 @@
+#ifndef mpi_static_cpp
+#define mpi_static_cpp
+
+#include "mpi_common.cpp"
+
+// Every process gets an equal share of the masks up front and the partial sums are added up on the master.
+
+
+// Numbers which MPI can't add go to the master as bytes and are added there.
+template<typename Number>
+Number sumOnMaster(int rank, int procNum, const Number& localSum) {
+    std::string localBuffer = encodeNumber(localSum);
+    int localSize = (int)localBuffer.size();
+
+    std::vector<int> sizes(procNum), offsets(procNum);
+    MPI_Gather(&localSize, 1, MPI_INT, sizes.data(), 1, MPI_INT, MASTER_RANK, MPI_COMM_WORLD);
+
+    std::string allBuffers;
+    if (rank == MASTER_RANK) {
+        int totalSize = 0;
+        for (int r = 0; r < procNum; ++r) {
+            offsets[r] = totalSize;
+            totalSize += sizes[r];
+        }
+        allBuffers.resize(totalSize);
+    }
+
+    MPI_Gatherv(&localBuffer[0], localSize, MPI_CHAR,
+                &allBuffers[0], sizes.data(), offsets.data(), MPI_CHAR,
+                MASTER_RANK, MPI_COMM_WORLD);
+
+    Number totalSum = 0;
+    if (rank == MASTER_RANK) {
+        for (int r = 0; r < procNum; ++r) {
+            Number partialSum;
+            decodeNumber(allBuffers.data() + offsets[r], sizes[r], partialSum);
+            totalSum += partialSum;
+        }
+    }
+    return totalSum;
+}
+
+inline long long sumOnMaster(int rank, int procNum, long long localSum) {
+    long long totalSum = 0;
+    MPI_Reduce(&localSum, &totalSum, 1, MPI_LONG_LONG_INT, MPI_SUM, MASTER_RANK, MPI_COMM_WORLD);
+    return totalSum;
+}
+
+// Adds residues lane by lane, each one modulo its own modulus.
+inline void addResidueLanes(void *in, void *inout, int *length, MPI_Datatype *type) {
+    const unsigned long long *source = (const unsigned long long*)in;
+    unsigned long long *destination = (unsigned long long*)inout;
+    const ResidueModuli& installed = residueModuli();
+    for (int i = 0; i < *length && i < installed.count; ++i) {
+        destination[i] = installed.moduli[i].add(destination[i], source[i]);
+    }
+}
+
+inline ResidueSum sumOnMaster(int rank, int procNum, const ResidueSum& localSum) {
+    MPI_Op addResidues;
+    MPI_Op_create(addResidueLanes, 1, &addResidues);
+
+    ResidueSum totalSum;
+    MPI_Reduce(localSum.residues, totalSum.residues, CRT_MAX_MODULI, MPI_UINT64_T, addResidues, MASTER_RANK, MPI_COMM_WORLD);
+
+    MPI_Op_free(&addResidues);
+    return totalSum;
+}
+
+// Where the share of rank starts when [0, limit) is split between procNum processes; the first limit % procNum
+// shares are one longer. limit * rank would overflow for ranges of 2^62 masks.
+inline long long procRangeStart(long long limit, int rank, int procNum) {
+    return limit / procNum * rank + std::min<long long>(rank, limit % procNum);
+}
+
+template<typename Runner, typename Number>
+typename Runner::Sum runMpiStatic(const Runner& runner, const SubsetProblem<Number>& problem, const BackendOptions& options) {
+    int rank, procNum;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &procNum);
+
+    // split the range as evenly as possible; after canonicalization it may be shorter than the number of processes
+    const long long limit = runner.rangeLimit();
+    const long long procStart = procRangeStart(limit, rank, procNum);
+    const long long procEnd = procRangeStart(limit, rank + 1, procNum);
+    if (options.debug >= 1) {
+        MPIPrintf("limit = %lli, procStart = %lli, procEnd = %lli\n", limit, procStart, procEnd);
+    }
+
+    typename Runner::Sum localSum = sumChunk(runner, options, procStart, procEnd);
+    if (options.debug >= 1) {
+        MPIPrintf("localSum = %s\n", numberToString(localSum).c_str());
+    }
+
+    return sumOnMaster(rank, procNum, localSum);
+}
+
+
+#endif // mpi_static_cpp
@@ -0,0 +1,13 @@
+#ifndef sequential_cpp
+#define sequential_cpp
+
+#include "backend_common.cpp"
+
+// The whole range in the calling thread, as a single chunk.
+template<typename Runner, typename Number>
+typename Runner::Sum runSequential(const Runner& runner, const SubsetProblem<Number>& problem, const BackendOptions& options) {
+    return sumChunk(runner, options, 0, runner.rangeLimit());
+}
+
+
+#endif // sequential_cpp
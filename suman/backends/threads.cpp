@@ -0,0 +1,102 @@
+#ifndef threads_cpp
+#define threads_cpp
+
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../data_structures/lock_free_stack.cpp"
+#include "../data_structures/lock_free_queue.cpp"
+#include "backend_common.cpp"
+
+// Shared-memory backend: the chunk starts go into a lock-free work list, the threads (the calling one
+// included) pop chunks until it's empty and push their partial sums into a second lock-free list.
+
+const int THREADS_NUM_CHUNKS = 32;
+
+template<typename Runner, template<typename> class WorkList>
+void doWorkerThread(int rank,
+                    const Runner& runner,
+                    const BackendOptions& options,
+                    long long chunkSize,
+                    long long limit,
+                    WorkList<long long>& chunkStarts,
+                    WorkList<typename Runner::Sum>& partialSums) {
+    std::shared_ptr<long long> chunkStart;
+    while (chunkStart = chunkStarts.pop()) {
+        const long long chunkEnd = chunkEndFor(*chunkStart, chunkSize, limit);
+        typename Runner::Sum partialSum = sumChunk(runner, options, *chunkStart, chunkEnd);
+        partialSums.push(partialSum);
+
+        if (options.debug >= 2) {
+            printf("%i: Computed answer for mask interval [%lli,%lli): %s\n",
+                   rank,
+                   *chunkStart,
+                   chunkEnd,
+                   numberToString(partialSum).c_str());
+        }
+    }
+}
+
+template<typename Runner, typename Number, template<typename> class WorkList>
+typename Runner::Sum runThreadsOn(const Runner& runner, const SubsetProblem<Number>& problem, const BackendOptions& options) {
+    typedef typename Runner::Sum Sum;
+    WorkList<long long> chunkStarts;
+    WorkList<Sum> partialSums;
+
+    const long long limit = runner.rangeLimit();
+    const long long chunkSize = chunkSizeFor(limit, THREADS_NUM_CHUNKS); // threads which find no chunk left just finish
+    if (options.debug >= 1) {
+        printf("chunkSize = %lli\n", chunkSize);
+    }
+
+    for (long long chunkStart = 0; chunkStart < limit; chunkStart += chunkSize) {
+        chunkStarts.push(chunkStart);
+    }
+
+    std::vector<std::thread> workerThreads;
+    for (int i = 1; i < options.threads; ++i) {
+        workerThreads.push_back(std::thread(doWorkerThread<Runner, WorkList>,
+                                            i,
+                                            std::cref(runner),
+                                            std::cref(options),
+                                            chunkSize,
+                                            limit,
+                                            std::ref(chunkStarts),
+                                            std::ref(partialSums)));
+    }
+
+    doWorkerThread<Runner, WorkList>(0, runner, options, chunkSize, limit, chunkStarts, partialSums); // main thread works as well
+
+    for (std::thread& t : workerThreads) {
+        t.join();
+    }
+
+    Sum totalSum = 0;
+    std::shared_ptr<Sum> partialSum;
+    int count = 0;
+    while (partialSum = partialSums.pop()) {
+        totalSum += *partialSum;
+        count += 1;
+    }
+
+    if (options.debug >= 1) {
+        printf("Got %i partial sums from the worker threads\n", count);
+    }
+
+    return totalSum;
+}
+
+template<typename Runner, typename Number>
+typename Runner::Sum runThreads(const Runner& runner, const SubsetProblem<Number>& problem, const BackendOptions& options) {
+    if (options.workList == WORK_LIST_QUEUE) {
+        return runThreadsOn<Runner, Number, lock_free_queue>(runner, problem, options);
+    }
+    else {
+        return runThreadsOn<Runner, Number, lock_free_stack>(runner, problem, options);
+    }
+}
+
+
+#endif // threads_cpp
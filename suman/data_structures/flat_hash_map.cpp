@@ -0,0 +1,123 @@
+#ifndef flat_hash_map_cpp
+#define flat_hash_map_cpp
+
+#include <cstddef>
+#include <vector>
+
+// Open-addressing hash map with linear probing, kept in one contiguous array of slots so
+// that lookups touch as few cache lines as possible.
+//
+// The caller hashes the keys itself and passes an equality predicate on lookup. That way a key
+// can be a handle to data stored somewhere else (e.g. an index into an mpz_arena) and a lookup
+// never has to build a key just to compare it. Each slot keeps the full hash, so most
+// mismatches are rejected without calling the predicate at all.
+//
+// There is no erase; entries are dropped by rebuilding into another map.
+
+template<typename Key, typename Value>
+class flat_hash_map
+{
+private:
+    struct slot
+    {
+        unsigned long long hash; // 0 marks an empty slot
+        Key key;
+        Value value;
+    };
+
+    std::vector<slot> slots;
+    std::size_t count;
+
+    static unsigned long long nonzero_hash(unsigned long long hash)
+    {
+        return hash | 1;
+    }
+
+    void grow()
+    {
+        std::vector<slot> old_slots(slots.size() * 2);
+        old_slots.swap(slots);
+
+        const std::size_t mask = slots.size() - 1;
+        for (const slot& s : old_slots) {
+            if (s.hash == 0) {
+                continue;
+            }
+
+            std::size_t i = s.hash & mask;
+            while (slots[i].hash != 0) {
+                i = (i + 1) & mask;
+            }
+            slots[i] = s;
+        }
+    }
+
+public:
+    // capacity is rounded up to a power of two
+    explicit flat_hash_map(std::size_t capacity = 16): count(0)
+    {
+        std::size_t size = 16;
+        while (size < capacity) {
+            size *= 2;
+        }
+        slots.resize(size);
+    }
+
+    std::size_t size() const
+    {
+        return count;
+    }
+
+    // keeps the memory of the slots
+    void clear()
+    {
+        if (count == 0) {
+            return;
+        }
+
+        for (slot& s : slots) {
+            s.hash = 0;
+        }
+        count = 0;
+    }
+
+    // Returns the value stored for the key which matches equal(key), inserting make_key() with a
+    // value-initialized Value if there is no such key. make_key is only called on insertion.
+    template<typename Equal, typename MakeKey>
+    Value& find_or_insert(unsigned long long hash, Equal equal, MakeKey make_key)
+    {
+        if ((count + 1) * 4 > slots.size() * 3) { // keep the load factor under 3/4
+            grow();
+        }
+
+        hash = nonzero_hash(hash);
+        const std::size_t mask = slots.size() - 1;
+        std::size_t i = hash & mask;
+        while (slots[i].hash != 0) {
+            if (slots[i].hash == hash && equal(slots[i].key)) {
+                return slots[i].value;
+            }
+            i = (i + 1) & mask;
+        }
+
+        slots[i].hash = hash;
+        slots[i].key = make_key();
+        slots[i].value = Value();
+        count += 1;
+        return slots[i].value;
+    }
+
+    // f(key, value) for every entry, in slot order
+    template<typename Function>
+    void for_each(Function f) const
+    {
+        for (const slot& s : slots) {
+            if (s.hash != 0) {
+                f(s.key, s.value);
+            }
+        }
+    }
+};
+
+
+#endif // flat_hash_map_cpp
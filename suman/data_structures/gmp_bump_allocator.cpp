@@ -0,0 +1,169 @@
+#ifndef gmp_bump_allocator_cpp
+#define gmp_bump_allocator_cpp
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <gmp.h>
+
+// Opt-in allocator for the limbs of GMP numbers (registered with mp_set_memory_functions),
+// made of one bump arena per thread.
+//
+// While a thread is inside a chunk (between begin_chunk() and end_chunk()), the memory GMP asks
+// for is carved out of that thread's arena: no lock and no free list is touched. Freeing arena
+// memory does nothing and end_chunk() takes the whole arena back at once. Requests which are too
+// big for the arena or don't fit in what is left of it, and every request made outside of a
+// chunk, go to the heap.
+//
+// Numbers which got arena memory during a chunk must not be used after end_chunk() and must not
+// be handed to another thread; whatever outlives the chunk has to be copied after suspend()
+// (which sends new requests back to the heap) and before end_chunk().
+
+struct gmp_arena_stats
+{
+    long long arena_allocations;
+    long long arena_bytes;
+    long long heap_allocations; // made during the chunk but served by the heap
+    long long heap_bytes;
+};
+
+class gmp_bump_allocator
+{
+public:
+    static const std::size_t ARENA_BYTES = 1 << 22;
+    static const std::size_t MAX_ARENA_REQUEST = ARENA_BYTES / 16; // bigger ones are "oversized"
+
+    // Not thread-safe: call it once, before starting the threads. The heap side uses malloc, realloc
+    // and free, like GMP's own functions, so numbers created before that stay valid.
+    static void install()
+    {
+        mp_set_memory_functions(allocate, reallocate, deallocate);
+    }
+
+    static void begin_chunk()
+    {
+        arena& a = local();
+        if (a.memory == NULL) {
+            a.memory = (char*)malloc(ARENA_BYTES);
+        }
+
+        a.used = 0;
+        a.active = (a.memory != NULL);
+        memset(&a.stats, 0, sizeof(a.stats));
+    }
+
+    // New requests go to the heap again; the arena memory stays valid until end_chunk().
+    static void suspend()
+    {
+        local().active = false;
+    }
+
+    static gmp_arena_stats end_chunk()
+    {
+        arena& a = local();
+        a.active = false;
+        a.used = 0;
+        return a.stats;
+    }
+
+private:
+    struct arena
+    {
+        char *memory;
+        std::size_t used;
+        bool active;
+        gmp_arena_stats stats;
+
+        arena(): memory(NULL), used(0), active(false)
+        {
+            memset(&stats, 0, sizeof(stats));
+        }
+
+        ~arena()
+        {
+            free(memory);
+            memory = NULL;
+        }
+    };
+
+    static arena& local()
+    {
+        static thread_local arena a;
+        return a;
+    }
+
+    static std::size_t round_up(std::size_t size)
+    {
+        return (size + 15) & ~(std::size_t)15;
+    }
+
+    static bool owns(const arena& a, void *pointer)
+    {
+        return a.memory != NULL && (char*)pointer >= a.memory && (char*)pointer < a.memory + ARENA_BYTES;
+    }
+
+    static void* heap_or_die(void *pointer)
+    {
+        if (pointer == NULL) {
+            fprintf(stderr, "GNU MP: Cannot allocate memory\n");
+            abort();
+        }
+        return pointer;
+    }
+
+    static void* allocate(std::size_t size)
+    {
+        arena& a = local();
+        if (a.active && size <= MAX_ARENA_REQUEST && a.used + round_up(size) <= ARENA_BYTES) {
+            void *pointer = a.memory + a.used;
+            a.used += round_up(size);
+            a.stats.arena_allocations += 1;
+            a.stats.arena_bytes += size;
+            return pointer;
+        }
+
+        if (a.active) {
+            a.stats.heap_allocations += 1;
+            a.stats.heap_bytes += size;
+        }
+        return heap_or_die(malloc(size));
+    }
+
+    static void* reallocate(void *pointer, std::size_t old_size, std::size_t new_size)
+    {
+        arena& a = local();
+        if (!owns(a, pointer)) {
+            if (a.active) {
+                a.stats.heap_allocations += 1;
+                a.stats.heap_bytes += new_size;
+            }
+            return heap_or_die(realloc(pointer, new_size));
+        }
+
+        // the last block of the arena can grow in place
+        const bool is_last = ((char*)pointer + round_up(old_size) == a.memory + a.used);
+        if (a.active && is_last && new_size <= MAX_ARENA_REQUEST
+            && (std::size_t)((char*)pointer - a.memory) + round_up(new_size) <= ARENA_BYTES) {
+            a.used = ((char*)pointer - a.memory) + round_up(new_size);
+            a.stats.arena_allocations += 1;
+            a.stats.arena_bytes += new_size;
+            return pointer;
+        }
+
+        void *moved = allocate(new_size);
+        memcpy(moved, pointer, (old_size < new_size) ? old_size : new_size);
+        return moved;
+    }
+
+    static void deallocate(void *pointer, std::size_t size)
+    {
+        if (!owns(local(), pointer)) {
+            free(pointer);
+        }
+    }
+};
+
+
+#endif // gmp_bump_allocator_cpp
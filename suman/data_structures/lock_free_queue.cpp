@@ -3,6 +3,7 @@
 
 // This implementation is from Anthony Williams's book Concurrency in Action
 
+#include <cassert>
 #include <cstring>
 #include <memory>
 #include <atomic>
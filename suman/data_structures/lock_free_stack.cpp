@@ -1,6 +1,7 @@
 #ifndef lock_free_stack_cpp
 #define lock_free_stack_cpp
 
+#include <memory>
 #include <atomic>
 
 // This implementation is from Anthony Williams's book Concurrency in Action
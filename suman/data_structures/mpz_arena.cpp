@@ -0,0 +1,52 @@
+#ifndef mpz_arena_cpp
+#define mpz_arena_cpp
+
+#include <vector>
+
+#include <gmpxx.h>
+
+// Bump arena of big integers, addressed by index.
+//
+// reset() only rewinds the arena: the numbers keep their limbs, so storing a value in a
+// slot which was used before is just a copy into memory GMP already owns. Tables which are
+// cleared and refilled many times (see lcm_map.cpp) stop allocating once the arena is warm.
+
+class mpz_arena
+{
+private:
+    std::vector<mpz_class> numbers;
+    unsigned used;
+
+public:
+    mpz_arena(): used(0)
+    {
+    }
+
+    unsigned store(const mpz_class& number)
+    {
+        if (used == numbers.size()) {
+            numbers.emplace_back();
+        }
+
+        numbers[used] = number;
+        return used++;
+    }
+
+    const mpz_class& operator[](unsigned index) const
+    {
+        return numbers[index];
+    }
+
+    unsigned size() const
+    {
+        return used;
+    }
+
+    void reset()
+    {
+        used = 0;
+    }
+};
+
+
+#endif // mpz_arena_cpp
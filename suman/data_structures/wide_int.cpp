@@ -0,0 +1,396 @@
+#ifndef wide_int_cpp
+#define wide_int_cpp
+
+#include <algorithm>
+#include <utility>
+
+// Fixed-width unsigned integer of Limbs 64-bit limbs (little-endian), for numbers which are too big
+// for a machine word but small enough that GMP's heap-allocated integers are overkill.
+// Everything lives in the object itself, so these can sit on the stack and in registers.
+//
+// Arithmetic wraps around modulo 2^(64 * Limbs), like unsigned built-in types do;
+// multiply_overflows is there for the places where a product has to be checked.
+// wide_int gives the same bits a two's complement reading.
+
+template<int Limbs>
+class wide_uint
+{
+public:
+    typedef unsigned long long limb;
+    typedef unsigned __int128 double_limb;
+
+    limb limbs[Limbs];
+
+    wide_uint(limb value = 0)
+    {
+        limbs[0] = value;
+        for (int i = 1; i < Limbs; ++i) {
+            limbs[i] = 0;
+        }
+    }
+
+    bool is_zero() const
+    {
+        limb any = 0;
+        for (int i = 0; i < Limbs; ++i) {
+            any |= limbs[i];
+        }
+        return any == 0;
+    }
+
+    bool fits_limb() const
+    {
+        limb any = 0;
+        for (int i = 1; i < Limbs; ++i) {
+            any |= limbs[i];
+        }
+        return any == 0;
+    }
+
+    int bit_length() const
+    {
+        for (int i = Limbs - 1; i >= 0; --i) {
+            if (limbs[i] != 0) {
+                return 64 * i + 64 - __builtin_clzll(limbs[i]);
+            }
+        }
+        return 0;
+    }
+
+    // the 128 bits starting at bit position start
+    double_limb bits_from(int start) const
+    {
+        const int first = start / 64, offset = start % 64;
+        limb part[3];
+        for (int i = 0; i < 3; ++i) {
+            part[i] = (first + i < Limbs) ? limbs[first + i] : 0;
+        }
+
+        if (offset == 0) {
+            return ((double_limb)part[1] << 64) | part[0];
+        }
+        limb low = (part[0] >> offset) | (part[1] << (64 - offset));
+        limb high = (part[1] >> offset) | (part[2] << (64 - offset));
+        return ((double_limb)high << 64) | low;
+    }
+
+    // the number of limbs up to the most significant non-zero one
+    int used_limbs() const
+    {
+        int used = Limbs;
+        while (used > 0 && limbs[used - 1] == 0) {
+            used -= 1;
+        }
+        return used;
+    }
+
+    // must not be zero
+    int trailing_zeros() const
+    {
+        int i = 0;
+        while (limbs[i] == 0) {
+            i += 1;
+        }
+        return 64 * i + __builtin_ctzll(limbs[i]);
+    }
+
+    wide_uint& operator+=(const wide_uint& other)
+    {
+        double_limb carry = 0;
+        for (int i = 0; i < Limbs; ++i) {
+            carry += (double_limb)limbs[i] + other.limbs[i];
+            limbs[i] = (limb)carry;
+            carry >>= 64;
+        }
+        return *this;
+    }
+
+    wide_uint& operator-=(const wide_uint& other)
+    {
+        limb borrow = 0;
+        for (int i = 0; i < Limbs; ++i) {
+            double_limb difference = (double_limb)limbs[i] - other.limbs[i] - borrow;
+            limbs[i] = (limb)difference;
+            borrow = (limb)(difference >> 64) & 1;
+        }
+        return *this;
+    }
+
+    // product = a * b; returns true if the full product doesn't fit (product is then truncated).
+    // product may be the same object as a or b.
+    static bool multiply_overflows(const wide_uint& a, const wide_uint& b, wide_uint& product)
+    {
+        limb result[2 * Limbs] = {};
+        const int used = b.used_limbs();
+        for (int i = 0; i < Limbs; ++i) {
+            if (a.limbs[i] == 0) {
+                continue;
+            }
+
+            double_limb carry = 0;
+            for (int j = 0; j < used; ++j) {
+                carry += (double_limb)a.limbs[i] * b.limbs[j] + result[i + j];
+                result[i + j] = (limb)carry;
+                carry >>= 64;
+            }
+            result[i + used] = (limb)carry;
+        }
+
+        limb high = 0;
+        for (int i = 0; i < Limbs; ++i) {
+            product.limbs[i] = result[i];
+            high |= result[i + Limbs];
+        }
+        return high != 0;
+    }
+
+    // truncated to the low Limbs limbs, so only the partial products which land there are computed
+    wide_uint& operator*=(const wide_uint& other)
+    {
+        limb result[Limbs] = {};
+        const int used = other.used_limbs();
+        for (int i = 0; i < Limbs; ++i) {
+            if (limbs[i] == 0) {
+                continue;
+            }
+
+            double_limb carry = 0;
+            for (int j = 0; j < used && i + j < Limbs; ++j) {
+                carry += (double_limb)limbs[i] * other.limbs[j] + result[i + j];
+                result[i + j] = (limb)carry;
+                carry >>= 64;
+            }
+            if (i + used < Limbs) {
+                result[i + used] = (limb)carry;
+            }
+        }
+
+        for (int i = 0; i < Limbs; ++i) {
+            limbs[i] = result[i];
+        }
+        return *this;
+    }
+
+    wide_uint& operator<<=(int bits)
+    {
+        const int limb_shift = bits / 64, bit_shift = bits % 64;
+        for (int i = Limbs - 1; i >= 0; --i) {
+            limb value = (i - limb_shift >= 0) ? limbs[i - limb_shift] << bit_shift : 0;
+            if (bit_shift != 0 && i - limb_shift - 1 >= 0) {
+                value |= limbs[i - limb_shift - 1] >> (64 - bit_shift);
+            }
+            limbs[i] = value;
+        }
+        return *this;
+    }
+
+    wide_uint& operator>>=(int bits)
+    {
+        const int limb_shift = bits / 64, bit_shift = bits % 64;
+        for (int i = 0; i < Limbs; ++i) {
+            limb value = (i + limb_shift < Limbs) ? limbs[i + limb_shift] >> bit_shift : 0;
+            if (bit_shift != 0 && i + limb_shift + 1 < Limbs) {
+                value |= limbs[i + limb_shift + 1] << (64 - bit_shift);
+            }
+            limbs[i] = value;
+        }
+        return *this;
+    }
+
+    // (high * 2^64 + low) / divisor, with the remainder in remainder. Needs high < divisor,
+    // so that the quotient fits in a limb; that's a single instruction on x86-64.
+    static limb divide_double_limb(limb high, limb low, limb divisor, limb& remainder)
+    {
+#if defined(__x86_64__)
+        limb quotient;
+        __asm__("divq %4" : "=a"(quotient), "=d"(remainder) : "a"(low), "d"(high), "rm"(divisor));
+        return quotient;
+#else
+        double_limb current = ((double_limb)high << 64) | low;
+        remainder = (limb)(current % divisor);
+        return (limb)(current / divisor);
+#endif
+    }
+
+    // *this /= divisor; returns the remainder. divisor must not be zero.
+    limb divide_by_limb(limb divisor)
+    {
+        limb remainder = 0;
+        for (int i = used_limbs() - 1; i >= 0; --i) {
+            limbs[i] = divide_double_limb(remainder, limbs[i], divisor, remainder);
+        }
+        return remainder;
+    }
+
+    // quotient = dividend / divisor, rounded down. divisor must not be zero.
+    static void divide(const wide_uint& dividend, const wide_uint& divisor, wide_uint& quotient)
+    {
+        if (divisor.fits_limb()) {
+            quotient = dividend;
+            quotient.divide_by_limb(divisor.limbs[0]);
+            return;
+        }
+
+        const int divisor_bits = divisor.bit_length();
+        const int steps = dividend.bit_length() - divisor_bits;
+        quotient = 0;
+        if (steps < 0) {
+            return;
+        }
+
+        if (steps < 64) {
+            // the quotient fits in a limb: estimate it from the top 64 bits of the divisor, which is
+            // at most 2 too big (Knuth's algorithm D), and correct the estimate
+            const int shift = divisor_bits - 64;
+            const double_limb top_dividend = dividend.bits_from(shift);
+            const limb top_divisor = (limb)divisor.bits_from(shift);
+
+            limb remainder;
+            limb estimate = divide_double_limb((limb)(top_dividend >> 64), (limb)top_dividend, top_divisor, remainder);
+            wide_uint product;
+            while (multiply_overflows(divisor, wide_uint(estimate), product)) {
+                estimate -= 1; // the product went past 2^(64 * Limbs), so it's over the dividend too
+            }
+            while (dividend < product) {
+                estimate -= 1;
+                product -= divisor;
+            }
+
+            quotient.limbs[0] = estimate;
+            return;
+        }
+
+        // shift-and-subtract, one step per bit of the quotient
+        wide_uint remainder = dividend, shifted = divisor;
+
+        shifted <<= steps;
+        for (int step = steps; step >= 0; --step) {
+            if (!(remainder < shifted)) {
+                remainder -= shifted;
+                quotient.limbs[step / 64] |= 1ULL << (step % 64);
+            }
+            shifted >>= 1;
+        }
+    }
+
+    friend bool operator==(const wide_uint& a, const wide_uint& b)
+    {
+        limb difference = 0;
+        for (int i = 0; i < Limbs; ++i) {
+            difference |= a.limbs[i] ^ b.limbs[i];
+        }
+        return difference == 0;
+    }
+
+    friend bool operator!=(const wide_uint& a, const wide_uint& b)
+    {
+        return !(a == b);
+    }
+
+    friend bool operator<(const wide_uint& a, const wide_uint& b)
+    {
+        for (int i = Limbs - 1; i >= 0; --i) {
+            if (a.limbs[i] != b.limbs[i]) {
+                return a.limbs[i] < b.limbs[i];
+            }
+        }
+        return false;
+    }
+
+    friend bool operator>(const wide_uint& a, const wide_uint& b)
+    {
+        return b < a;
+    }
+
+    friend bool operator<=(const wide_uint& a, const wide_uint& b)
+    {
+        return !(b < a);
+    }
+
+    static limb gcd_of_limbs(limb x, limb y)
+    {
+        if (x == 0 || y == 0) {
+            return x | y;
+        }
+
+        const int shift = __builtin_ctzll(x | y);
+        x >>= __builtin_ctzll(x);
+        while (y != 0) {
+            y >>= __builtin_ctzll(y);
+            if (x > y) {
+                std::swap(x, y);
+            }
+            y -= x;
+        }
+        return x << shift;
+    }
+
+    friend wide_uint gcd(wide_uint a, wide_uint b)
+    {
+        if (a.is_zero()) {
+            return b;
+        }
+        if (b.is_zero()) {
+            return a;
+        }
+
+        // one remainder usually brings both operands down to a single limb
+        if (b.fits_limb()) {
+            a = wide_uint(a.divide_by_limb(b.limbs[0]));
+            std::swap(a, b);
+        }
+        else if (a.fits_limb()) {
+            b = wide_uint(b.divide_by_limb(a.limbs[0]));
+        }
+
+        if (a.fits_limb() && b.fits_limb()) {
+            return wide_uint(gcd_of_limbs(a.limbs[0], b.limbs[0]));
+        }
+
+        // binary gcd on the whole width
+        const int shift = std::min(a.trailing_zeros(), b.trailing_zeros());
+        a >>= a.trailing_zeros();
+        while (!b.is_zero()) {
+            b >>= b.trailing_zeros();
+            if (b < a) {
+                std::swap(a, b);
+            }
+            b -= a;
+        }
+        a <<= shift;
+        return a;
+    }
+};
+
+// The two's complement reading of a wide_uint: a sum which went below zero along the way and wrapped
+// around is read back as the negative number it stands for.
+template<int Limbs>
+class wide_int
+{
+public:
+    wide_uint<Limbs> bits;
+
+    explicit wide_int(const wide_uint<Limbs>& bits): bits(bits)
+    {
+    }
+
+    bool is_negative() const
+    {
+        return (bits.limbs[Limbs - 1] >> 63) != 0;
+    }
+
+    // the absolute value, as an unsigned number
+    wide_uint<Limbs> magnitude() const
+    {
+        if (!is_negative()) {
+            return bits;
+        }
+
+        wide_uint<Limbs> result = 0;
+        result -= bits;
+        return result;
+    }
+};
+
+
+#endif // wide_int_cpp
@@ -0,0 +1,220 @@
+#ifndef bonferroni_cpp
+#define bonferroni_cpp
+
+#include <vector>
+
+#include <gmpxx.h>
+
+#include "subset_problem.cpp"
+#include "tiered.cpp"
+
+// An early answer with a guaranteed error: the subsets are summed level by level, in order of their size.
+// With S_k the sum of the terms L * T(N / L) of the subsets of size k, the partial sums
+// P_k = S_1 - S_2 + ... +- S_k are alternately upper (k odd) and lower (k even) bounds of the answer
+// (the Bonferroni inequalities: they hold for every number in [1, N] on its own, so for their sum too).
+// So after every level the answer is known to be in [lower, upper], and the interval only shrinks;
+// once a level has no subset whose lcm is at most N, neither do the bigger ones and the interval is the answer.
+//
+// A level is summed by a depth-limited DFS which only adds the terms of its subsets, with a runner like the
+// kernels' (the chunks are ranges of the first divisor of a subset, as in prefix_dfs.cpp), so the backends
+// split every level between threads or processes. Summing level k walks levels 1 .. k - 1 again, which costs
+// less than level k itself when the levels grow, and more of them can't be afforded when they don't.
+//
+// The point estimate treats the divisors as independent: a fraction 1 - (1 - 1 / v_1) ... (1 - 1 / v_K)
+// of [1, N] is divisible by one of them, weighed by the values that's T(N) times that fraction. It's exact
+// for pairwise coprime divisors and a large N, and it's clamped to [lower, upper].
+
+// The problem in both number types: the levels run on 64-bit lcms when N fits in a long long.
+struct BonferroniProblem {
+    const SubsetProblem<mpz_class>& problem;
+    bool inWords;
+    SubsetProblem<long long> wordProblem;
+
+    explicit BonferroniProblem(const SubsetProblem<mpz_class>& problem):
+        problem(problem),
+        inWords(problem.N.fits_slong_p()) { // the canonical divisors are at most N
+
+        if (inWords) {
+            wordProblem.N = problem.N.get_si();
+            for (const mpz_class& divisor : problem.divisors) {
+                wordProblem.divisors.push_back(divisor.get_si());
+            }
+        }
+    }
+};
+
+// The signed terms of 64-bit subsets, in a 128-bit integer which goes into an mpz_class before it can overflow
+// (a term is at most T(N) < 2^125).
+const int128 LEVEL_PENDING_LIMIT = (int128)1 << 126;
+
+class LevelAccumulator {
+public:
+    LevelAccumulator():
+        pending(0) {
+    }
+
+    void addTerm(long long N, long long commonMultiple, int elementCount) {
+        const uint128 subsetCardinality = N / commonMultiple;
+        const int128 term = (int128)(commonMultiple * (subsetCardinality * (subsetCardinality + 1) / 2));
+
+        if (pending >= LEVEL_PENDING_LIMIT || pending <= -LEVEL_PENDING_LIMIT) {
+            addInt128(total, pending, scratch);
+            pending = 0;
+        }
+        pending += (elementCount & 1) ? term : -term;
+    }
+
+    mpz_class sum() {
+        addInt128(total, pending, scratch);
+        pending = 0;
+        return total;
+    }
+
+private:
+    int128 pending;
+    mpz_class total, scratch;
+};
+
+inline void addSubsetTerm(LevelAccumulator& sum, long long N, long long commonMultiple, int elementCount) {
+    sum.addTerm(N, commonMultiple, elementCount);
+}
+
+// Adds the terms of the subsets of size level which extend the current one (of size depth) with divisors from firstBit on.
+template<typename Number, typename Sum>
+void sumLevelDFS(const SubsetProblem<Number>& problem,
+                 int firstBit,
+                 int depth,
+                 int level,
+                 std::vector<Number>& lcmAtDepth,
+                 Sum& sum) {
+    const int lastBit = problem.numDivisors() - (level - depth); // the rest of the subset needs the divisors after it
+    for (int b = firstBit; b <= lastBit; ++b) {
+        Number& commonMultiple = lcmAtDepth[depth + 1];
+        if (!lcmWithinLimit(lcmAtDepth[depth], problem.divisors[b], problem.N, commonMultiple)) {
+            continue;
+        }
+
+        if (depth + 1 == level) {
+            addSubsetTerm(sum, problem.N, commonMultiple, level);
+        }
+        else {
+            sumLevelDFS(problem, b + 1, depth + 1, level, lcmAtDepth, sum);
+        }
+    }
+}
+
+// Sums one level, +-S_level, over ranges of the first divisor of the subsets.
+class BonferroniLevelRunner {
+public:
+    typedef mpz_class Sum;
+
+    BonferroniLevelRunner(const BonferroniProblem& bonferroni, int level):
+        bonferroni(bonferroni),
+        level(level) {
+    }
+
+    long long rangeLimit() const {
+        return bonferroni.problem.numDivisors();
+    }
+
+    mpz_class sumForRange(long long rangeStart, long long rangeEnd) const {
+        if (bonferroni.inWords) {
+            LevelAccumulator sum;
+            sumFirstDivisors(bonferroni.wordProblem, rangeStart, rangeEnd, sum);
+            return sum.sum();
+        }
+
+        mpz_class sum = 0;
+        sumFirstDivisors(bonferroni.problem, rangeStart, rangeEnd, sum);
+        return sum;
+    }
+
+private:
+    const BonferroniProblem& bonferroni;
+    const int level;
+
+    template<typename Number, typename LevelSum>
+    void sumFirstDivisors(const SubsetProblem<Number>& problem, long long rangeStart, long long rangeEnd, LevelSum& sum) const {
+        std::vector<Number> lcmAtDepth(level + 1);
+        for (int first = (int)rangeStart; first < (int)rangeEnd; ++first) {
+            lcmAtDepth[1] = problem.divisors[first];
+            if (lcmAtDepth[1] > problem.N) {
+                continue; // only happens if the divisors weren't canonicalized
+            }
+
+            if (level == 1) {
+                addSubsetTerm(sum, problem.N, lcmAtDepth[1], 1);
+            }
+            else {
+                sumLevelDFS(problem, first + 1, 1, level, lcmAtDepth, sum);
+            }
+        }
+    }
+};
+
+// The interval [lower, upper] after the levels summed so far.
+struct BonferroniBounds {
+    int levels;
+    mpz_class partialSum; // P_levels
+    mpz_class lower, upper;
+    bool exact; // the last level was empty, so partialSum is the answer
+
+    explicit BonferroniBounds(const mpz_class& N):
+        levels(0),
+        partialSum(0),
+        lower(0),
+        upper(N * (N + 1) / 2),
+        exact(false) {
+    }
+
+    // levelSum is what the BonferroniLevelRunner of the next level summed.
+    void addLevel(const mpz_class& levelSum) {
+        levels += 1;
+        if (levelSum == 0) { // no subset of this size (they'd all add up with the same sign), so none bigger either
+            exact = true;
+            lower = upper = partialSum;
+            return;
+        }
+
+        partialSum += levelSum;
+        if (levels % 2 == 1 && partialSum < upper) {
+            upper = partialSum;
+        }
+        if (levels % 2 == 0 && partialSum > lower) {
+            lower = partialSum;
+        }
+    }
+
+    // Whether upper - lower is at most tolerance * upper.
+    bool within(double tolerance) const {
+        if (exact || lower == upper) {
+            return true;
+        }
+        mpf_class width(upper - lower), bound(upper);
+        return width <= bound * tolerance;
+    }
+};
+
+// T(N) * (1 - (1 - 1 / v_1) ... (1 - 1 / v_K)), clamped to the bounds.
+inline mpz_class densityEstimate(const SubsetProblem<mpz_class>& problem, const BonferroniBounds& bounds) {
+    double notDivisible = 1;
+    for (const mpz_class& divisor : problem.divisors) {
+        notDivisible *= 1 - 1 / divisor.get_d();
+    }
+
+    const mpz_class& N = problem.N;
+    mpf_class estimate(N * (N + 1) / 2, 64 + mpz_sizeinbase(N.get_mpz_t(), 2) * 2);
+    estimate *= 1 - notDivisible;
+
+    mpz_class result(estimate);
+    if (result < bounds.lower) {
+        result = bounds.lower;
+    }
+    if (result > bounds.upper) {
+        result = bounds.upper;
+    }
+    return result;
+}
+
+
+#endif // bonferroni_cpp
@@ -0,0 +1,82 @@
+#ifndef canonicalize_cpp
+#define canonicalize_cpp
+
+#include <stdio.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Preprocessing of the divisors, done once before any enumeration.
+// Every dropped divisor halves the number of subsets, without changing the answer:
+// - duplicates;
+// - divisors bigger than N (no multiple of them is in [1, N]);
+// - multiples of another divisor (if a | b, every multiple of b is already counted through a).
+//
+// The divisors which are left are sorted in decreasing order. Both the DFS engine and the
+// mask iterator extend a subset with the divisors that come after it, so having the small
+// divisors last means that the extensions which are tried are the ones most likely to stay under N.
+
+struct CanonicalizationReport {
+    int originalCount;
+    int duplicates;
+    int biggerThanN;
+    int multiples;
+    int finalCount;
+};
+
+// Divisor may be narrower than Number (e.g. int divisors with a long long N).
+template<typename Number, typename Divisor>
+CanonicalizationReport canonicalizeDivisors(const Number& N, std::vector<Divisor>& divisors) {
+    CanonicalizationReport report;
+    report.originalCount = (int)divisors.size();
+
+    std::sort(divisors.begin(), divisors.end());
+    divisors.erase(std::unique(divisors.begin(), divisors.end()), divisors.end());
+    report.duplicates = report.originalCount - (int)divisors.size();
+
+    int countBeforeLimit = (int)divisors.size();
+    while (!divisors.empty() && divisors.back() > N) {
+        divisors.pop_back();
+    }
+    report.biggerThanN = countBeforeLimit - (int)divisors.size();
+
+    // ascending order, so only the divisors already kept can divide the current one
+    std::vector<Divisor> kept;
+    for (const Divisor& d : divisors) {
+        bool isMultiple = false;
+        for (const Divisor& smaller : kept) {
+            if (d % smaller == 0) {
+                isMultiple = true;
+                break;
+            }
+        }
+
+        if (!isMultiple) {
+            kept.push_back(d);
+        }
+    }
+    report.multiples = (int)divisors.size() - (int)kept.size();
+
+    std::reverse(kept.begin(), kept.end());
+    divisors.swap(kept);
+    report.finalCount = (int)divisors.size();
+
+    return report;
+}
+
+inline std::string describeCanonicalization(const CanonicalizationReport& report) {
+    char buffer[256];
+    snprintf(buffer,
+             sizeof(buffer),
+             "Canonical divisors: K went from %i to %i (dropped %i duplicates, %i bigger than N, %i multiples of others)",
+             report.originalCount,
+             report.finalCount,
+             report.duplicates,
+             report.biggerThanN,
+             report.multiples);
+
+    return std::string(buffer);
+}
+
+
+#endif // canonicalize_cpp
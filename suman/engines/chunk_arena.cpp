@@ -0,0 +1,37 @@
+#ifndef chunk_arena_cpp
+#define chunk_arena_cpp
+
+#include <gmpxx.h>
+
+#include "../data_structures/gmp_bump_allocator.cpp"
+#include "subset_problem.cpp"
+
+// Evaluates one chunk with the GMP numbers it creates living in the calling thread's bump arena
+// (only effective once gmp_bump_allocator::install() was called).
+//
+// The thread's scratch registers are swapped for a fresh set for the duration of the chunk,
+// since they would otherwise grow into the arena and be left pointing into it afterwards.
+// The sum is copied out to the heap before the arena is reset.
+template<typename SumFunction>
+mpz_class sumInChunkArena(SumFunction computeSum, gmp_arena_stats& stats) {
+    mpz_class result;
+
+    gmp_bump_allocator::begin_chunk();
+    {
+        MpzScratch chunkScratch;
+        MpzScratch *threadRegisters = threadScratchSlot();
+        threadScratchSlot() = &chunkScratch;
+
+        mpz_class sum = computeSum();
+
+        gmp_bump_allocator::suspend();
+        result = sum;
+        threadScratchSlot() = threadRegisters;
+    }
+    stats = gmp_bump_allocator::end_chunk();
+
+    return result;
+}
+
+
+#endif // chunk_arena_cpp
@@ -0,0 +1,137 @@
+#ifndef clique_cpp
+#define clique_cpp
+
+#include <vector>
+
+#include "subset_problem.cpp"
+
+// Clique enumeration over the compatibility graph of the divisors.
+//
+// A subset can only contribute if every pair in it has an lcm which isn't bigger than N, i.e. if it's
+// a clique of the graph with an edge between every two compatible divisors. The graph is built once,
+// as one bitset row per divisor, holding the compatible divisors which come after it. The DFS keeps
+// the candidates which are compatible with every divisor of the current subset as a bitset, so
+// extending the subset with b narrows them with a word-wide AND of b's row, and the real lcm is only
+// computed for the divisors which survive. When the graph is sparse (big divisors) the dead branches
+// go away without a single gcd.
+//
+// Like the prefix kernel (see prefix_dfs.cpp), the range of a chunk is one of first divisor indices,
+// so there's no limit on the number of divisors.
+
+struct CompatibilityGraph {
+    int words; // per row
+    std::vector<unsigned long long> rows; // rows[i * words + j / 64] has bit j % 64 set if j > i and lcm(v_i, v_j) <= N
+
+    const unsigned long long *row(int i) const {
+        return rows.data() + (long long)i * words;
+    }
+};
+
+template<typename Number>
+CompatibilityGraph buildCompatibilityGraph(const SubsetProblem<Number>& problem) {
+    const int numDivisors = problem.numDivisors();
+
+    CompatibilityGraph graph;
+    graph.words = (numDivisors + 63) / 64;
+    graph.rows.assign((long long)numDivisors * graph.words, 0);
+
+    Number commonMultiple;
+    for (int i = 0; i < numDivisors; ++i) {
+        unsigned long long *row = graph.rows.data() + (long long)i * graph.words;
+        for (int j = i + 1; j < numDivisors; ++j) {
+            if (lcmWithinLimit(problem.divisors[i], problem.divisors[j], problem.N, commonMultiple)) {
+                row[j / 64] |= (1ULL << (j % 64));
+            }
+        }
+    }
+
+    return graph;
+}
+
+// The scratch space of one DFS: candidatesAtDepth[depth] are the divisors which can still extend the
+// subset at that depth, and lcmAtDepth[depth] is its lcm. Both grow as deep as the biggest clique.
+template<typename Number>
+struct CliqueScratch {
+    std::vector<std::vector<unsigned long long>> candidatesAtDepth;
+    std::vector<Number> lcmAtDepth;
+};
+
+// Adds the terms of every clique which extends the subset at depth with divisors from candidatesAtDepth[depth].
+// The words before firstWord are all 0.
+template<typename Number>
+void sumCliquesDFS(const SubsetProblem<Number>& problem,
+                   const CompatibilityGraph& graph,
+                   int depth,
+                   int firstWord,
+                   int elementCount,
+                   CliqueScratch<Number>& scratch,
+                   Number& sum) {
+    if ((int)scratch.candidatesAtDepth.size() <= depth + 1) {
+        scratch.candidatesAtDepth.resize(depth + 2, std::vector<unsigned long long>(graph.words));
+        scratch.lcmAtDepth.resize(depth + 2);
+    }
+
+    for (int w = firstWord; w < graph.words; ++w) {
+        // a copy, since the deeper calls don't touch this depth but the vectors may be reallocated
+        unsigned long long bits = scratch.candidatesAtDepth[depth][w];
+        while (bits != 0) {
+            const int b = w * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+
+            Number& commonMultiple = scratch.lcmAtDepth[depth + 1];
+            if (!lcmWithinLimit(scratch.lcmAtDepth[depth], problem.divisors[b], problem.N, commonMultiple)) {
+                continue; // compatible with each divisor on its own, but not with all of them together
+            }
+
+            addSubsetTerm(sum, problem.N, commonMultiple, elementCount + 1);
+
+            // the row of b only has divisors after b, so the words before b's word stay 0
+            const unsigned long long *row = graph.row(b);
+            const std::vector<unsigned long long>& candidates = scratch.candidatesAtDepth[depth];
+            std::vector<unsigned long long>& next = scratch.candidatesAtDepth[depth + 1];
+            unsigned long long any = 0;
+            for (int v = w; v < graph.words; ++v) {
+                next[v] = candidates[v] & row[v];
+                any |= next[v];
+            }
+
+            if (any != 0) {
+                sumCliquesDFS(problem, graph, depth + 1, w, elementCount + 1, scratch, sum);
+            }
+        }
+    }
+}
+
+// Returns the sum of the terms of the subsets whose first divisor is in [firstStart, firstEnd).
+template<typename Number>
+Number sumForPrefixRangeCliques(const SubsetProblem<Number>& problem, const CompatibilityGraph& graph, long long firstStart, long long firstEnd) {
+    CliqueScratch<Number> scratch;
+    scratch.candidatesAtDepth.resize(2, std::vector<unsigned long long>(graph.words));
+    scratch.lcmAtDepth.resize(2);
+    Number sum = 0;
+
+    for (int first = (int)firstStart; first < (int)firstEnd; ++first) {
+        scratch.lcmAtDepth[1] = problem.divisors[first];
+        if (scratch.lcmAtDepth[1] > problem.N) {
+            continue; // only happens if the divisors weren't canonicalized
+        }
+
+        addSubsetTerm(sum, problem.N, scratch.lcmAtDepth[1], 1);
+
+        const unsigned long long *row = graph.row(first);
+        unsigned long long any = 0;
+        for (int w = 0; w < graph.words; ++w) {
+            scratch.candidatesAtDepth[1][w] = row[w];
+            any |= row[w];
+        }
+
+        if (any != 0) {
+            sumCliquesDFS(problem, graph, 1, first / 64, 1, scratch, sum);
+        }
+    }
+
+    return sum;
+}
+
+
+#endif // clique_cpp
@@ -0,0 +1,106 @@
+#ifndef gray_product_cpp
+#define gray_product_cpp
+
+#include <vector>
+
+#include "subset_problem.cpp"
+#include "subset_dfs.cpp"
+
+// Gray-code walk for pairwise coprime divisors (e.g. the distinct primes of a number, like in pinex).
+//
+// When no two divisors share a factor, the lcm of a subset is the product of its divisors, so no
+// gcd is needed. The low bits of every aligned block are visited in reflected Gray-code order,
+// where each step flips the single bit ctz(step) and the sign of the term.
+//
+// productFrom[j] is the product of the block's shared high bits and of the current low bits j and
+// above, or 0 once that's over N. Flipping bit b only changes productFrom[0..b], which are rebuilt
+// with one checked multiplication each; bit b flips every 2^(b+1) steps, so that's O(1) per subset
+// on average and the subset's lcm is productFrom[0].
+//
+// When setting bit b makes productFrom[b] go over N, the next 2^b - 1 steps only flip the bits
+// below b, so every one of them is a superset of a too-big subset and the walk jumps over them.
+
+template<typename Number>
+bool divisorsArePairwiseCoprime(const SubsetProblem<Number>& problem) {
+    for (int i = 0; i < problem.numDivisors(); ++i) {
+        for (int j = i + 1; j < problem.numDivisors(); ++j) {
+            if (greatestCommonDivisor(problem.divisors[i], problem.divisors[j]) != 1) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// productFrom has at least lowBits + 1 entries.
+template<typename Number>
+void sumMaskBlockGray(const SubsetProblem<Number>& problem,
+                      long long blockStart,
+                      int lowBits,
+                      std::vector<Number>& productFrom,
+                      Number& sum) {
+    int prefixCount;
+    if (!lcmOfMaskBits(problem, blockStart, lowBits, productFrom[lowBits], prefixCount)) {
+        return; // the bits shared by the whole block are already too big
+    }
+
+    if (prefixCount > 0) { // the empty subset (mask 0) doesn't count
+        addSubsetTerm(sum, problem.N, productFrom[lowBits], prefixCount);
+    }
+
+    // no low bit is set yet
+    for (int j = 0; j < lowBits; ++j) {
+        productFrom[j] = productFrom[lowBits];
+    }
+
+    const long long steps = 1LL << lowBits;
+    long long grayMask = 0;
+    for (long long step = 1; step < steps; ++step) {
+        const int flipped = __builtin_ctzll(step);
+        grayMask ^= (1LL << flipped);
+
+        for (int j = flipped; j >= 0; --j) {
+            const Number& above = productFrom[j + 1];
+            if (!(grayMask & (1LL << j))) {
+                productFrom[j] = above;
+            }
+            else if (above == 0 || !multiplyWithinLimit(above, problem.divisors[j], problem.N, productFrom[j])) {
+                productFrom[j] = 0;
+            }
+        }
+
+        if ((grayMask & (1LL << flipped)) && productFrom[flipped] == 0) {
+            // the steps up to the next flip of a higher bit keep everything from bit flipped up
+            step += (1LL << flipped) - 1;
+            grayMask = (step ^ (step >> 1)) & (steps - 1);
+            continue;
+        }
+
+        // every step flips one bit, so the size of the subset has the parity of the step
+        if (productFrom[0] != 0) {
+            addSubsetTerm(sum, problem.N, productFrom[0], prefixCount + (int)(step & 1));
+        }
+    }
+}
+
+// Returns the same value as iterating over every mask in [rangeStart, rangeEnd).
+// pairwiseCoprime is what divisorsArePairwiseCoprime returned; otherwise the DFS engine is used.
+template<typename Number>
+Number sumForMaskRangeGray(const SubsetProblem<Number>& problem, bool pairwiseCoprime, long long rangeStart, long long rangeEnd) {
+    if (!pairwiseCoprime) {
+        return sumForMaskRangeDFS(problem, rangeStart, rangeEnd);
+    }
+
+    const int numDivisors = problem.numDivisors();
+    std::vector<Number> productFrom(numDivisors + 1);
+    Number sum = 0;
+
+    forEachAlignedBlock(rangeStart, rangeEnd, numDivisors, [&](long long blockStart, int lowBits) {
+        sumMaskBlockGray(problem, blockStart, lowBits, productFrom, sum);
+    });
+
+    return sum;
+}
+
+
+#endif // gray_product_cpp
@@ -0,0 +1,197 @@
+#ifndef lcm_map_cpp
+#define lcm_map_cpp
+
+#include <utility>
+
+#include <gmpxx.h>
+
+#include "../data_structures/flat_hash_map.cpp"
+#include "../data_structures/mpz_arena.cpp"
+#include "subset_problem.cpp"
+
+// Sparse lcm -> coefficient engine.
+//
+// Many subsets share the same lcm and the answer only depends on
+//     sum over the distinct lcms L of coefficient(L) * L * T(N / L),
+// where coefficient(L) = (number of odd subsets with lcm L) - (number of even subsets with lcm L)
+// and T(q) = q * (q + 1) / 2. So instead of enumerating subsets, the divisors are added one at a
+// time to a table of (L, coefficient): adding d keeps every entry and adds (lcm(L, d), -coefficient).
+// Entries whose lcm goes over N are never created and entries whose coefficient cancels to zero
+// are dropped, so the work is proportional to the number of distinct live lcms, not to 2^K.
+
+
+inline unsigned long long mixHash(unsigned long long x) { // splitmix64 finalizer
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// How the lcms are stored in the table: inline for long long, as handles into an arena for mpz_class.
+template<typename Number>
+class LcmKeys;
+
+template<>
+class LcmKeys<long long> {
+public:
+    typedef long long Key;
+
+    unsigned long long hash(long long lcm) const {
+        return mixHash((unsigned long long)lcm);
+    }
+
+    bool equals(Key key, long long lcm) const {
+        return key == lcm;
+    }
+
+    Key store(long long lcm) {
+        return lcm;
+    }
+
+    long long get(Key key) const {
+        return key;
+    }
+
+    void reset() {
+    }
+};
+
+template<>
+class LcmKeys<mpz_class> {
+public:
+    typedef unsigned Key;
+
+    unsigned long long hash(const mpz_class& lcm) const {
+        const mpz_srcptr number = lcm.get_mpz_t();
+        unsigned long long h = mpz_size(number);
+        for (size_t i = 0; i < mpz_size(number); ++i) {
+            h = mixHash(h ^ mpz_getlimbn(number, i));
+        }
+        return h;
+    }
+
+    bool equals(Key key, const mpz_class& lcm) const {
+        return arena[key] == lcm;
+    }
+
+    Key store(const mpz_class& lcm) {
+        return arena.store(lcm);
+    }
+
+    const mpz_class& get(Key key) const {
+        return arena[key];
+    }
+
+    void reset() {
+        arena.reset();
+    }
+
+private:
+    mpz_arena arena;
+};
+
+
+template<typename Number>
+class LcmCoefficientTable {
+public:
+    void clear() {
+        entries.clear();
+        keys.reset();
+    }
+
+    size_t size() const {
+        return entries.size();
+    }
+
+    void add(const Number& lcm, long long coefficient) {
+        long long& stored = entries.find_or_insert(
+            keys.hash(lcm),
+            [&](const Key& key) { return keys.equals(key, lcm); },
+            [&]() { return keys.store(lcm); });
+
+        stored += coefficient;
+    }
+
+    // f(lcm, coefficient); the coefficient may be zero if it cancelled out
+    template<typename Function>
+    void forEach(Function f) const {
+        entries.for_each([&](const Key& key, long long coefficient) {
+            f(keys.get(key), coefficient);
+        });
+    }
+
+private:
+    typedef typename LcmKeys<Number>::Key Key;
+
+    flat_hash_map<Key, long long> entries;
+    LcmKeys<Number> keys;
+};
+
+
+// Adds the terms of the masks in [blockStart, blockStart + 2^lowBits). blockStart must be a multiple of 2^lowBits.
+// The two tables are only scratch space, kept by the caller so that their memory is reused between blocks.
+template<typename Number>
+void sumMaskBlockLcmMap(const SubsetProblem<Number>& problem,
+                        long long blockStart,
+                        int lowBits,
+                        LcmCoefficientTable<Number>& current,
+                        LcmCoefficientTable<Number>& next,
+                        Number& sum) {
+    Number prefixLcm;
+    int elementCount;
+    if (!lcmOfMaskBits(problem, blockStart, lowBits, prefixLcm, elementCount)) {
+        return; // the bits shared by the whole block are already too big
+    }
+
+    // the subset made of the shared bits; when there are none, this is the empty subset (with lcm 1)
+    current.clear();
+    current.add(prefixLcm, (elementCount & 1) ? 1 : -1);
+
+    Number commonMultiple;
+    for (int b = 0; b < lowBits; ++b) {
+        const Number& divisor = problem.divisors[b];
+
+        next.clear();
+        current.forEach([&](const Number& lcm, long long coefficient) {
+            if (coefficient == 0) {
+                return;
+            }
+
+            next.add(lcm, coefficient); // the subsets without divisor b
+            if (lcmWithinLimit(lcm, divisor, problem.N, commonMultiple)) {
+                next.add(commonMultiple, -coefficient); // the same subsets, with divisor b added
+            }
+        });
+
+        std::swap(current, next);
+    }
+
+    current.forEach([&](const Number& lcm, long long coefficient) {
+        if (coefficient != 0) {
+            addSubsetTermTimes(sum, problem.N, lcm, coefficient);
+        }
+    });
+
+    if (elementCount == 0) {
+        // the empty subset went in with coefficient -1 and lcm 1, take it back out
+        addSubsetTermTimes(sum, problem.N, Number(1), 1);
+    }
+}
+
+// Returns the same value as iterating over every mask in [rangeStart, rangeEnd).
+template<typename Number>
+Number sumForMaskRangeLcmMap(const SubsetProblem<Number>& problem, long long rangeStart, long long rangeEnd) {
+    LcmCoefficientTable<Number> current, next;
+    Number sum = 0;
+
+    forEachAlignedBlock(rangeStart, rangeEnd, problem.numDivisors(), [&](long long blockStart, int lowBits) {
+        sumMaskBlockLcmMap(problem, blockStart, lowBits, current, next, sum);
+    });
+
+    return sum;
+}
+
+
+#endif // lcm_map_cpp
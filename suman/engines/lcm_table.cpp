@@ -0,0 +1,97 @@
+#ifndef lcm_table_cpp
+#define lcm_table_cpp
+
+#include <algorithm>
+#include <vector>
+
+#include <gmpxx.h>
+
+#include "subset_problem.cpp"
+
+// Incremental lcm table over the low bits of a mask range.
+//
+// The masks of an aligned block share every bit above some position, so the lcm of those high
+// bits is computed once per block. The low bits are then filled into a table in increasing order,
+// with lcm[mask] = lcm(lcm[mask without its highest bit], v[highest bit]): that entry is always
+// filled already, so every subset costs one lookup and at most one lcm step. Since the divisors are
+// sorted in decreasing order, the step adds the smallest divisor of the subset, like the DFS does,
+// which measured faster than adding the lowest bit (the biggest divisor) instead.
+// A zero entry stands for an lcm over N.
+//
+// Unlike the DFS nothing is cut, which makes no difference on inputs where most subsets stay under N
+// (many small or coprime divisors with a big N) and saves the recursion there.
+// Blocks bigger than the table are done as several table-sized blocks.
+
+// The table should stay in L2: 2^15 long longs are 256 KiB,
+// while an mpz_class entry is 16 bytes plus its limbs.
+template<typename Number>
+int lcmTableBits() {
+    return 15;
+}
+
+template<>
+inline int lcmTableBits<mpz_class>() {
+    return 12;
+}
+
+// Returns the sum of the terms of the masks in [blockStart, blockStart + 2^tableBits).
+// blockStart must be a multiple of 2^tableBits and table must have at least 2^tableBits entries.
+// The sum and N are locals, so that the compiler doesn't have to assume that the table writes change them.
+template<typename Number>
+Number sumMaskBlockLcmTable(const SubsetProblem<Number>& problem, long long blockStart, int tableBits, std::vector<Number>& table) {
+    const Number N = problem.N;
+    const Number *divisors = problem.divisors.data();
+    Number sum = 0;
+    int prefixCount;
+    if (!lcmOfMaskBits(problem, blockStart, tableBits, table[0], prefixCount)) {
+        return sum; // the bits shared by the whole block are already too big
+    }
+
+    if (prefixCount > 0) { // the empty subset (mask 0) doesn't count
+        addSubsetTerm(sum, N, table[0], prefixCount);
+    }
+
+    // the masks with the same highest bit extend the entries below that bit with the same divisor,
+    // so the divisor (and whatever the compiler derives from it, e.g. N / divisor) stays in registers
+    const int elementParity = (prefixCount + 1) & 1;
+    for (int highestBit = 0; highestBit < tableBits; ++highestBit) {
+        const Number& divisor = divisors[highestBit];
+        const int highestMask = 1 << highestBit;
+
+        for (int parentMask = 0; parentMask < highestMask; ++parentMask) {
+            const Number& parent = table[parentMask];
+            Number& commonMultiple = table[highestMask | parentMask];
+            if (parent == 0 || !lcmWithinLimit(parent, divisor, N, commonMultiple)) {
+                commonMultiple = 0;
+                continue;
+            }
+
+            // only the parity of the element count matters, and parity is much cheaper than popcount without -mpopcnt
+            addSubsetTerm(sum, N, commonMultiple, elementParity ^ __builtin_parity(parentMask));
+        }
+    }
+
+    return sum;
+}
+
+// Returns the same value as iterating over every mask in [rangeStart, rangeEnd).
+template<typename Number>
+Number sumForMaskRangeLcmTable(const SubsetProblem<Number>& problem, long long rangeStart, long long rangeEnd) {
+    const int numDivisors = problem.numDivisors();
+    const int maxTableBits = std::min(lcmTableBits<Number>(), numDivisors);
+    std::vector<Number> table(1 << maxTableBits);
+    Number sum = 0;
+
+    forEachAlignedBlock(rangeStart, rangeEnd, numDivisors, [&](long long blockStart, int lowBits) {
+        const int tableBits = std::min(lowBits, maxTableBits);
+        const long long blockEnd = blockStart + (1LL << lowBits);
+        for (long long tableStart = blockStart; tableStart < blockEnd; tableStart += (1LL << tableBits)) {
+            sum += sumMaskBlockLcmTable(problem, tableStart, tableBits, table);
+        }
+    });
+
+    return sum;
+}
+
+
+#endif // lcm_table_cpp
@@ -0,0 +1,94 @@
+#ifndef mask_iterator_cpp
+#define mask_iterator_cpp
+
+#include "subset_problem.cpp"
+
+// Walks the masks of [rangeStart, rangeEnd) in increasing order, like the plain
+// `for (mask = rangeStart; mask < rangeEnd; ++mask)` loop, but remembers the last subset whose
+// lcm went over N and jumps over every later mask which is a superset of it.
+//
+// Unlike the DFS engine this works on any range, aligned or not, and visits the masks in
+// the same order as the original kernels.
+class SupersetSkippingMaskIterator {
+public:
+    SupersetSkippingMaskIterator(long long rangeStart, long long rangeEnd):
+        mask(rangeStart > 1 ? rangeStart : 1), // the empty subset (mask 0) doesn't count
+        rangeEnd(rangeEnd),
+        tooBigSubset(0) {
+
+    }
+
+    bool done() const {
+        return mask >= rangeEnd;
+    }
+
+    long long current() const {
+        return mask;
+    }
+
+    // moves to the next mask which isn't a superset of the remembered too-big subset
+    void next() {
+        mask += 1;
+        skipTooBigSupersets();
+    }
+
+    // tooBig must be a subset of the current mask; moves past the current mask as well
+    void skipSupersetsOf(long long tooBig) {
+        tooBigSubset = tooBig;
+        skipTooBigSupersets();
+    }
+
+private:
+    long long mask;
+    long long rangeEnd;
+    long long tooBigSubset;
+
+    void skipTooBigSupersets() {
+        if (tooBigSubset == 0 || (mask & tooBigSubset) != tooBigSubset) {
+            return;
+        }
+
+        // The smallest mask bigger than the current one which lacks the lowest bit of tooBigSubset:
+        // fill everything below that bit and add one, so that the carry clears the bit.
+        // Every mask in between contains the whole current mask, so it's a superset as well.
+        long long lowestBit = tooBigSubset & -tooBigSubset;
+        mask = (mask | (lowestBit - 1)) + 1;
+    }
+};
+
+// Returns the same value as iterating over every mask in [rangeStart, rangeEnd).
+template<typename Number>
+Number sumForMaskRangeSkipping(const SubsetProblem<Number>& problem, long long rangeStart, long long rangeEnd) {
+    Number sum = 0;
+    Number commonMultiple;
+
+    SupersetSkippingMaskIterator it(rangeStart, rangeEnd);
+    while (!it.done()) {
+        const long long mask = it.current();
+        bool tooBig = false;
+        commonMultiple = 1;
+
+        for (long long bits = mask; bits != 0; bits &= bits - 1) { // only the elements of the current subset
+            const int b = __builtin_ctzll(bits);
+            if (!lcmWithinLimit(commonMultiple, problem.divisors[b], problem.N, commonMultiple)) {
+                // the elements of mask up to b are already too big on their own
+                it.skipSupersetsOf(mask & ((2LL << b) - 1));
+                tooBig = true;
+                break;
+            }
+        }
+
+        if (tooBig) {
+            continue;
+        }
+
+        // only the parity of the element count matters, and parity is much cheaper than popcount without -mpopcnt
+        addSubsetTerm(sum, problem.N, commonMultiple, __builtin_parityll(mask));
+        it.next();
+    }
+
+    return sum;
+}
+
+
+#endif // mask_iterator_cpp
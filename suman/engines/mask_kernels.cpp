@@ -0,0 +1,238 @@
+#ifndef mask_kernels_cpp
+#define mask_kernels_cpp
+
+#include <cstring>
+
+#include "subset_problem.cpp"
+#include "subset_dfs.cpp"
+#include "mask_iterator.cpp"
+#include "prefix_dfs.cpp"
+#include "clique.cpp"
+#include "meet_in_middle.cpp"
+#include "segmented_sieve.cpp"
+#include "periodic.cpp"
+#include "lcm_map.cpp"
+#include "lcm_table.cpp"
+#include "gray_product.cpp"
+#include "simd_batch.cpp"
+#include "prime_exponents.cpp"
+#include "tiered.cpp"
+#include "wide.cpp"
+
+// The kernels which can sum a contiguous range of masks, i.e. which fit the
+// [chunkStart, chunkStart + chunkSize) protocol of the backends. They are chosen by name on the command line.
+// The prefix and clique kernels keep the protocol, but their range is one of first divisor indices (see prefix_dfs.cpp),
+// and the ranges of the sieve and period kernels are ones of segments of [0, N] or of [0, P) (see segmented_sieve.cpp, periodic.cpp).
+enum MaskKernel {
+    MASK_KERNEL_DFS,            // "dfs": pruned depth-first search over aligned blocks of the range
+    MASK_KERNEL_SUPERSET_SKIP,  // "skip": mask by mask, jumping over supersets of too-big subsets
+    MASK_KERNEL_LCM_MAP,        // "map": subsets aggregated by their lcm in a sparse lcm -> coefficient table
+    MASK_KERNEL_PRIME_EXPONENTS, // "exp": DFS with the lcm kept as a vector of prime exponents
+    MASK_KERNEL_TIERED,         // "tiered": DFS in 64-bit / 128-bit words, promoted to mpz_class only on overflow
+    MASK_KERNEL_WIDE,           // "wide": DFS on the narrowest fixed-width wide_uint which can't overflow
+    MASK_KERNEL_LCM_TABLE,      // "table": per-block table of low-bit lcms, each one lcm step from a filled entry
+    MASK_KERNEL_GRAY_PRODUCT,   // "gray": Gray-code walk with running products, for pairwise coprime divisors
+    MASK_KERNEL_SIMD_BATCH,     // "simd": the lcm table filled 4 or 8 entries at a time with AVX2 / AVX-512, for 64-bit numbers
+    MASK_KERNEL_PREFIX_DFS,     // "prefix": DFS over ranges of first divisors, without masks, for any number of divisors
+    MASK_KERNEL_CLIQUE,         // "clique": "prefix" only over cliques of pairwise compatible divisors, with bitset candidates
+    MASK_KERNEL_MEET_IN_MIDDLE, // "mitm": lcm tables of two halves of the divisors, joined pair by pair
+    MASK_KERNEL_SIEVE,          // "sieve": no subsets, the multiples of the divisors marked in a segmented bitset
+    MASK_KERNEL_PERIOD,         // "period": the sieve over one period lcm(v_1, ..., v_K), scaled up to N in closed form
+};
+
+// The tiered kernel is exact and mostly runs on machine words, so it is the default for GMP numbers.
+template<typename Number>
+MaskKernel defaultMaskKernel() {
+    return MASK_KERNEL_DFS;
+}
+
+template<>
+inline MaskKernel defaultMaskKernel<mpz_class>() {
+    return MASK_KERNEL_TIERED;
+}
+
+// Returns false if name isn't the name of a kernel.
+inline bool parseMaskKernel(const char *name, MaskKernel& kernel) {
+    if (strcmp(name, "dfs") == 0) {
+        kernel = MASK_KERNEL_DFS;
+    }
+    else if (strcmp(name, "skip") == 0) {
+        kernel = MASK_KERNEL_SUPERSET_SKIP;
+    }
+    else if (strcmp(name, "map") == 0) {
+        kernel = MASK_KERNEL_LCM_MAP;
+    }
+    else if (strcmp(name, "exp") == 0) {
+        kernel = MASK_KERNEL_PRIME_EXPONENTS;
+    }
+    else if (strcmp(name, "tiered") == 0) {
+        kernel = MASK_KERNEL_TIERED;
+    }
+    else if (strcmp(name, "wide") == 0) {
+        kernel = MASK_KERNEL_WIDE;
+    }
+    else if (strcmp(name, "table") == 0) {
+        kernel = MASK_KERNEL_LCM_TABLE;
+    }
+    else if (strcmp(name, "gray") == 0) {
+        kernel = MASK_KERNEL_GRAY_PRODUCT;
+    }
+    else if (strcmp(name, "simd") == 0) {
+        kernel = MASK_KERNEL_SIMD_BATCH;
+    }
+    else if (strcmp(name, "prefix") == 0) {
+        kernel = MASK_KERNEL_PREFIX_DFS;
+    }
+    else if (strcmp(name, "clique") == 0) {
+        kernel = MASK_KERNEL_CLIQUE;
+    }
+    else if (strcmp(name, "mitm") == 0) {
+        kernel = MASK_KERNEL_MEET_IN_MIDDLE;
+    }
+    else if (strcmp(name, "sieve") == 0) {
+        kernel = MASK_KERNEL_SIEVE;
+    }
+    else if (strcmp(name, "period") == 0) {
+        kernel = MASK_KERNEL_PERIOD;
+    }
+    else {
+        return false;
+    }
+
+    return true;
+}
+
+// Whether the range of the kernel is one of first divisor indices instead of masks,
+// which is what lets it run with more than MASK_MAX_DIVISORS divisors.
+inline bool kernelSplitsFirstDivisors(MaskKernel kernel) {
+    return kernel == MASK_KERNEL_PREFIX_DFS || kernel == MASK_KERNEL_CLIQUE;
+}
+
+// Whether the kernel can't run with more than MASK_MAX_DIVISORS divisors.
+inline bool kernelNeedsMasks(MaskKernel kernel) {
+    return !kernelSplitsFirstDivisors(kernel) && kernel != MASK_KERNEL_SIEVE && kernel != MASK_KERNEL_PERIOD;
+}
+
+// The kernel which runs when kernel is asked for: the sieve only takes a small N and the period kernel a small
+// lcm of all the divisors, and they give way to the default kernel (or to the prefix kernel, for more than
+// MASK_MAX_DIVISORS divisors) otherwise.
+template<typename Number>
+MaskKernel runnableKernel(MaskKernel kernel, const SubsetProblem<Number>& problem) {
+    if ((kernel == MASK_KERNEL_SIEVE && !fitsSieve(problem)) || (kernel == MASK_KERNEL_PERIOD && periodOf(problem) == 0)) {
+        return (problem.numDivisors() > MASK_MAX_DIVISORS) ? MASK_KERNEL_PREFIX_DFS : defaultMaskKernel<Number>();
+    }
+    return kernel;
+}
+
+// Runs the chosen kernel over mask ranges of one problem. Whatever a kernel needs to precompute
+// from the divisors (e.g. their factorization) is done once, in the constructor.
+// sumForRange is const and keeps its scratch space local, so threads can share a runner.
+// buildThreads is how many threads the precomputation may use (only the "mitm" tables are built in parallel).
+template<typename Number>
+class MaskKernelRunner {
+public:
+    typedef Number Sum; // what sumForRange returns, see also ResidueRunner
+    MaskKernelRunner(MaskKernel requestedKernel, const SubsetProblem<Number>& problem, int buildThreads = 1):
+        kernel(runnableKernel(requestedKernel, problem)),
+        problem(problem),
+        wideLimbs(0),
+        pairwiseCoprime(false),
+        simdLevel(SIMD_LEVEL_NONE) {
+
+        if (kernel == MASK_KERNEL_PRIME_EXPONENTS) {
+            primeBasis = buildPrimeExponentBasis(problem);
+        }
+        else if (kernel == MASK_KERNEL_TIERED) {
+            tieredProblem = buildTieredProblem(problem);
+        }
+        else if (kernel == MASK_KERNEL_WIDE) {
+            wideLimbs = wideLimbsFor(problem);
+        }
+        else if (kernel == MASK_KERNEL_GRAY_PRODUCT) {
+            pairwiseCoprime = divisorsArePairwiseCoprime(problem);
+        }
+        else if (kernel == MASK_KERNEL_SIMD_BATCH) {
+            simdLevel = simdLevelFor(problem);
+        }
+        else if (kernel == MASK_KERNEL_CLIQUE) {
+            compatibilityGraph = buildCompatibilityGraph(problem);
+        }
+        else if (kernel == MASK_KERNEL_MEET_IN_MIDDLE) {
+            meetInMiddleTables = buildMeetInMiddleTables(problem, buildThreads);
+        }
+        else if (kernel == MASK_KERNEL_SIEVE) {
+            sieveProblem = buildSieveProblem(problem);
+        }
+        else if (kernel == MASK_KERNEL_PERIOD) {
+            periodicProblem = buildPeriodicProblem(problem, periodOf(problem));
+        }
+    }
+
+    // The end of the range which the backends split: 2^K masks, K first divisors, the entries of the joined "mitm" table,
+    // or the segments of the sieve or of the period.
+    long long rangeLimit() const {
+        if (kernelSplitsFirstDivisors(kernel)) {
+            return problem.numDivisors();
+        }
+        if (kernel == MASK_KERNEL_MEET_IN_MIDDLE) {
+            return meetInMiddleTables.joined.lcms.size();
+        }
+        if (kernel == MASK_KERNEL_SIEVE) {
+            return sieveSegmentCount(sieveProblem);
+        }
+        if (kernel == MASK_KERNEL_PERIOD) {
+            return periodSegmentCount(periodicProblem);
+        }
+        return 1LL << problem.numDivisors();
+    }
+
+    Number sumForRange(long long rangeStart, long long rangeEnd) const {
+        switch (kernel) {
+            case MASK_KERNEL_SUPERSET_SKIP:
+                return sumForMaskRangeSkipping(problem, rangeStart, rangeEnd);
+            case MASK_KERNEL_LCM_MAP:
+                return sumForMaskRangeLcmMap(problem, rangeStart, rangeEnd);
+            case MASK_KERNEL_PRIME_EXPONENTS:
+                return sumForMaskRangeExponents(problem, primeBasis, rangeStart, rangeEnd);
+            case MASK_KERNEL_TIERED:
+                return sumForMaskRangeTiered(problem, tieredProblem, rangeStart, rangeEnd);
+            case MASK_KERNEL_WIDE:
+                return sumForMaskRangeWide(problem, wideLimbs, rangeStart, rangeEnd);
+            case MASK_KERNEL_LCM_TABLE:
+                return sumForMaskRangeLcmTable(problem, rangeStart, rangeEnd);
+            case MASK_KERNEL_GRAY_PRODUCT:
+                return sumForMaskRangeGray(problem, pairwiseCoprime, rangeStart, rangeEnd);
+            case MASK_KERNEL_SIMD_BATCH:
+                return sumForMaskRangeSimd(problem, simdLevel, rangeStart, rangeEnd);
+            case MASK_KERNEL_PREFIX_DFS:
+                return sumForPrefixRangeDFS(problem, rangeStart, rangeEnd);
+            case MASK_KERNEL_CLIQUE:
+                return sumForPrefixRangeCliques(problem, compatibilityGraph, rangeStart, rangeEnd);
+            case MASK_KERNEL_MEET_IN_MIDDLE:
+                return sumForJoinRange(problem, meetInMiddleTables, rangeStart, rangeEnd);
+            case MASK_KERNEL_SIEVE:
+                return sumForSegmentRange<Number>(sieveProblem, rangeStart, rangeEnd);
+            case MASK_KERNEL_PERIOD:
+                return sumForPeriodRange(periodicProblem, rangeStart, rangeEnd);
+            case MASK_KERNEL_DFS:
+            default:
+                return sumForMaskRangeDFS(problem, rangeStart, rangeEnd);
+        }
+    }
+
+private:
+    MaskKernel kernel;
+    const SubsetProblem<Number>& problem;
+    PrimeExponentBasis<Number> primeBasis;
+    TieredProblem tieredProblem;
+    int wideLimbs;
+    bool pairwiseCoprime;
+    SimdLevel simdLevel;
+    CompatibilityGraph compatibilityGraph;
+    MeetInMiddleTables<Number> meetInMiddleTables;
+    SieveProblem sieveProblem;
+    PeriodicProblem<Number> periodicProblem;
+};
+
+
+#endif // mask_kernels_cpp
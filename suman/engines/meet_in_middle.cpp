@@ -0,0 +1,220 @@
+#ifndef meet_in_middle_cpp
+#define meet_in_middle_cpp
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "subset_problem.cpp"
+#include "lcm_map.cpp"
+
+// Meet in the middle: the divisors are dealt into two halves A and B (alternately, so that both get
+// small and big divisors), and each half gets a table of its distinct lcms, built like the "map" kernel
+// (see lcm_map.cpp) but over every subset of the half, the empty one included, with
+//     coefficient(L) = (number of even subsets with lcm L) - (number of odd subsets with lcm L).
+// A subset of all the divisors is a pair (Sa, Sb) and its sign is -(-1)^|Sa| * (-1)^|Sb|, so
+//     answer = T(N) - sum over the pairs of entries a, b with lcm(La, Lb) <= N of
+//              coefficient(a) * coefficient(b) * lcm(La, Lb) * T(N / lcm(La, Lb)),
+// where T(N) takes out the pair of empty subsets. With K divisors each table has at most 2^(K/2)
+// entries and usually far fewer, so it reaches K around 40-60 when the lcms don't all stay under N.
+//
+// Most pairs can be dropped without computing their lcm. Every lcm of B divides M = lcm(B), so
+// gcd(La, Lb) divides gcd(La, M), and lcm(La, Lb) >= Lb * r(a) with r(a) = La / gcd(La, M), the part of La
+// which no divisor of B shares. Only the entries of B with Lb <= N / r(a) can pair with a. B is sorted
+// by lcm and A by r(a), so that bound only goes down along a range of A and is followed by a pointer
+// moving back through B.
+//
+// The range of a chunk is one of indices into the table of A, which takes the odd divisors: the entry
+// of the empty subset (lcm 1) is then never cancelled, as a divisor 1 is left alone by the
+// canonicalization, so the range is never empty and its first chunk adds T(N). The tables are built once, and with
+// several build threads each of them is split into pieces by the subsets of its first few divisors.
+
+template<typename Number>
+struct HalfLcmTable {
+    std::vector<Number> lcms;            // distinct, not bigger than N
+    std::vector<long long> coefficients; // never 0
+};
+
+template<typename Number>
+struct MeetInMiddleTables {
+    HalfLcmTable<Number> joined;    // A: the range of the chunks, sorted by unsharedParts
+    std::vector<Number> unsharedParts; // r(a) of every entry of A
+    HalfLcmTable<Number> scanned;   // B: sorted by lcm
+};
+
+// Adds the subsets of divisors[firstFree, end) to the ones in current and moves them all into result.
+// next is scratch space.
+template<typename Number>
+void extendLcmTable(const Number& N,
+                    const std::vector<Number>& divisors,
+                    int firstFree,
+                    LcmCoefficientTable<Number>& current,
+                    LcmCoefficientTable<Number>& next,
+                    LcmCoefficientTable<Number>& result) {
+    Number commonMultiple;
+    for (int i = firstFree; i < (int)divisors.size(); ++i) {
+        next.clear();
+        current.forEach([&](const Number& lcm, long long coefficient) {
+            if (coefficient == 0) {
+                return;
+            }
+
+            next.add(lcm, coefficient); // the subsets without divisor i
+            if (lcmWithinLimit(lcm, divisors[i], N, commonMultiple)) {
+                next.add(commonMultiple, -coefficient); // the same subsets, with divisor i added
+            }
+        });
+
+        std::swap(current, next);
+    }
+
+    current.forEach([&](const Number& lcm, long long coefficient) {
+        if (coefficient != 0) {
+            result.add(lcm, coefficient);
+        }
+    });
+}
+
+// The (even - odd) lcm table of every subset of divisors, sorted by lcm.
+// The subsets of the first pieceBits divisors are handed out to buildThreads threads as separate pieces.
+template<typename Number>
+HalfLcmTable<Number> buildHalfLcmTable(const Number& N, const std::vector<Number>& divisors, int buildThreads) {
+    int pieceBits = 0;
+    while (pieceBits < (int)divisors.size() && (1 << pieceBits) < 4 * buildThreads) {
+        pieceBits += 1;
+    }
+    const int numPieces = 1 << pieceBits;
+
+    std::vector<LcmCoefficientTable<Number>> results(buildThreads);
+    auto buildPieces = [&](int thread) {
+        LcmCoefficientTable<Number> current, next;
+        Number pieceLcm;
+        for (int piece = thread; piece < numPieces; piece += buildThreads) {
+            bool tooBig = false;
+            pieceLcm = 1;
+            for (int b = 0; b < pieceBits && !tooBig; ++b) {
+                if (piece & (1 << b)) {
+                    tooBig = !lcmWithinLimit(pieceLcm, divisors[b], N, pieceLcm);
+                }
+            }
+            if (tooBig) {
+                continue;
+            }
+
+            current.clear();
+            current.add(pieceLcm, __builtin_parity(piece) ? -1 : 1);
+            extendLcmTable(N, divisors, pieceBits, current, next, results[thread]);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 1; t < buildThreads; ++t) {
+        threads.push_back(std::thread(buildPieces, t));
+    }
+    buildPieces(0);
+    for (std::thread& t : threads) {
+        t.join();
+    }
+
+    for (int t = 1; t < buildThreads; ++t) {
+        results[t].forEach([&](const Number& lcm, long long coefficient) {
+            results[0].add(lcm, coefficient);
+        });
+    }
+
+    std::vector<std::pair<Number, long long>> entries;
+    results[0].forEach([&](const Number& lcm, long long coefficient) {
+        if (coefficient != 0) {
+            entries.push_back(std::make_pair(lcm, coefficient));
+        }
+    });
+    std::sort(entries.begin(), entries.end());
+
+    HalfLcmTable<Number> table;
+    table.lcms.reserve(entries.size());
+    table.coefficients.reserve(entries.size());
+    for (const std::pair<Number, long long>& entry : entries) {
+        table.lcms.push_back(entry.first);
+        table.coefficients.push_back(entry.second);
+    }
+    return table;
+}
+
+// La / gcd(La, lcm(scannedDivisors)), without computing that lcm: the gcd is the lcm of gcd(La, d) over the divisors d.
+template<typename Number>
+Number unsharedPartOf(const Number& lcm, const std::vector<Number>& scannedDivisors) {
+    Number shared = 1;
+    for (const Number& divisor : scannedDivisors) {
+        if (shared == lcm) {
+            break;
+        }
+        Number common = greatestCommonDivisor(lcm, divisor);
+        shared = shared / greatestCommonDivisor(shared, common) * common; // divides lcm, so it can't overflow
+    }
+    return lcm / shared;
+}
+
+template<typename Number>
+MeetInMiddleTables<Number> buildMeetInMiddleTables(const SubsetProblem<Number>& problem, int buildThreads) {
+    std::vector<Number> joinedDivisors, scannedDivisors;
+    for (int i = 0; i < problem.numDivisors(); ++i) {
+        if (i % 2 == 1) {
+            joinedDivisors.push_back(problem.divisors[i]);
+        }
+        else {
+            scannedDivisors.push_back(problem.divisors[i]);
+        }
+    }
+
+    MeetInMiddleTables<Number> tables;
+    tables.scanned = buildHalfLcmTable(problem.N, scannedDivisors, buildThreads);
+    HalfLcmTable<Number> joined = buildHalfLcmTable(problem.N, joinedDivisors, buildThreads);
+
+    // sort A by r(a)
+    std::vector<std::pair<Number, int>> order(joined.lcms.size());
+    for (int a = 0; a < (int)joined.lcms.size(); ++a) {
+        order[a] = std::make_pair(unsharedPartOf(joined.lcms[a], scannedDivisors), a);
+    }
+    std::sort(order.begin(), order.end());
+
+    for (const std::pair<Number, int>& entry : order) {
+        tables.joined.lcms.push_back(joined.lcms[entry.second]);
+        tables.joined.coefficients.push_back(joined.coefficients[entry.second]);
+        tables.unsharedParts.push_back(entry.first);
+    }
+    return tables;
+}
+
+// Returns the sum of the terms of the subsets whose half in A is one of the entries [joinedStart, joinedEnd) of A.
+template<typename Number>
+Number sumForJoinRange(const SubsetProblem<Number>& problem, const MeetInMiddleTables<Number>& tables, long long joinedStart, long long joinedEnd) {
+    const std::vector<Number>& scannedLcms = tables.scanned.lcms;
+    Number sum = 0;
+    if (joinedStart == 0 && joinedEnd > 0) { // a range may be empty, e.g. the share of an MPI process
+        addSubsetTerm(sum, problem.N, Number(1), 1); // the pair of empty subsets, see above
+    }
+
+    Number commonMultiple, bound;
+    long long scannedEnd = scannedLcms.size(); // the entries of B from scannedEnd on are over the bound of every a so far
+    for (long long a = joinedStart; a < joinedEnd; ++a) {
+        const Number& joinedLcm = tables.joined.lcms[a];
+        const long long joinedCoefficient = tables.joined.coefficients[a];
+
+        bound = problem.N / tables.unsharedParts[a];
+        while (scannedEnd > 0 && scannedLcms[scannedEnd - 1] > bound) {
+            scannedEnd -= 1;
+        }
+
+        for (long long b = 0; b < scannedEnd; ++b) {
+            if (lcmWithinLimit(joinedLcm, scannedLcms[b], problem.N, commonMultiple)) {
+                addSubsetTermTimes(sum, problem.N, commonMultiple, -joinedCoefficient * tables.scanned.coefficients[b]);
+            }
+        }
+    }
+
+    return sum;
+}
+
+
+#endif // meet_in_middle_cpp
@@ -0,0 +1,274 @@
+#ifndef multi_query_cpp
+#define multi_query_cpp
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include <gmpxx.h>
+
+#include "subset_problem.cpp"
+#include "lcm_map.cpp"
+#include "tiered.cpp"
+
+// Many N for one set of divisors. The answer for N is
+//     f(N) = sum over the distinct lcms L <= N of coefficient(L) * L * T(N / L)
+// (see lcm_map.cpp), and the table of (L, coefficient) doesn't depend on N, except for which entries
+// are left out for being over it. So the table is built once, with the recurrence of the map kernel over
+// all the divisors, pruned against the biggest N asked for, and every N is then one pass over the entries
+// up to it. An interval [A, B] is f(B) - f(A - 1).
+//
+// The table is sorted by lcm and the queried values of N (the points) too, so the points which an entry
+// counts for are a suffix of them, which only shrinks. That suffix is divided by the entry's lcm a few points
+// at a time, in double precision with vector instructions: below 2^52 the rounded quotient is off by at most
+// one, which the remainder corrects. Bigger points are divided one by one.
+//
+// With 64-bit numbers the sums wrap around like those of the kernels. With GMP numbers, the table and the
+// quotients are still 64-bit words when the biggest N fits in a long long, and every point gets a 128-bit sum
+// which goes into its mpz_class before it can overflow; otherwise the whole thing runs on GMP numbers.
+
+template<typename Number>
+struct IntervalQuery {
+    Number low, high; // f(high) - f(low - 1); just f(N) is the interval [1, N]
+};
+
+// The entries with a non-zero coefficient, in increasing order of their lcm.
+template<typename Number>
+struct QueryTable {
+    std::vector<Number> lcms;
+    std::vector<long long> coefficients;
+};
+
+template<typename Number>
+QueryTable<Number> buildQueryTable(const SubsetProblem<Number>& problem) {
+    LcmCoefficientTable<Number> current, next;
+    current.add(Number(1), -1); // the empty subset, taken back out below
+
+    Number commonMultiple;
+    for (const Number& divisor : problem.divisors) {
+        next.clear();
+        current.forEach([&](const Number& lcm, long long coefficient) {
+            if (coefficient == 0) {
+                return;
+            }
+
+            next.add(lcm, coefficient); // the subsets without the divisor
+            if (lcmWithinLimit(lcm, divisor, problem.N, commonMultiple)) {
+                next.add(commonMultiple, -coefficient); // the same subsets, with the divisor added
+            }
+        });
+        std::swap(current, next);
+    }
+    current.add(Number(1), 1);
+
+    std::vector<std::pair<Number, long long>> entries;
+    current.forEach([&](const Number& lcm, long long coefficient) {
+        if (coefficient != 0) {
+            entries.push_back(std::make_pair(lcm, coefficient));
+        }
+    });
+    std::sort(entries.begin(), entries.end(), [](const std::pair<Number, long long>& a, const std::pair<Number, long long>& b) {
+        return a.first < b.first;
+    });
+
+    QueryTable<Number> table;
+    for (const std::pair<Number, long long>& entry : entries) {
+        table.lcms.push_back(entry.first);
+        table.coefficients.push_back(entry.second);
+    }
+    return table;
+}
+
+// The distinct values of N which the queries need, in increasing order.
+template<typename Number>
+std::vector<Number> queryPoints(const std::vector<IntervalQuery<Number>>& queries) {
+    std::vector<Number> points;
+    for (const IntervalQuery<Number>& query : queries) {
+        points.push_back(query.low - 1);
+        points.push_back(query.high);
+    }
+    std::sort(points.begin(), points.end());
+    points.erase(std::unique(points.begin(), points.end()), points.end());
+    return points;
+}
+
+
+const int QUERY_LANES = 4;
+const long long QUERY_DOUBLE_LIMIT = 1LL << 52; // the points below it are divided in double precision
+
+typedef double QueryDoubles __attribute__((vector_size(QUERY_LANES * sizeof(double))));
+typedef long long QueryWords __attribute__((vector_size(QUERY_LANES * sizeof(long long))));
+
+// The points as words and as doubles, both padded with QUERY_LANES zeros for the last vector.
+struct QueryPoints {
+    std::vector<long long> words;
+    std::vector<double> doubles;
+    size_t count;
+    size_t doubleEnd; // the points before it are below QUERY_DOUBLE_LIMIT
+
+    explicit QueryPoints(const std::vector<long long>& points):
+        words(points),
+        count(points.size()) {
+
+        words.resize(count + QUERY_LANES, 0);
+        doubles.assign(words.begin(), words.end());
+        doubleEnd = std::lower_bound(points.begin(), points.end(), QUERY_DOUBLE_LIMIT) - points.begin();
+    }
+};
+
+// quotients[j] = points[j] / divisor for j in [first, count); quotients has room for the padding.
+inline void divideQueryPoints(const QueryPoints& points, size_t first, long long divisor, std::vector<long long>& quotients) {
+    const QueryDoubles inverse = QueryDoubles{} + 1.0 / (double)divisor;
+    const QueryWords divisorLanes = QueryWords{} + divisor;
+
+    size_t j = first;
+    for (; j < points.doubleEnd; j += QUERY_LANES) {
+        QueryDoubles asDoubles;
+        QueryWords words;
+        memcpy(&asDoubles, points.doubles.data() + j, sizeof(asDoubles));
+        memcpy(&words, points.words.data() + j, sizeof(words));
+
+        QueryWords quotient = __builtin_convertvector(asDoubles * inverse, QueryWords);
+        const QueryWords remainder = words - quotient * divisorLanes;
+        quotient += (remainder < 0); // a true comparison is -1 in every lane
+        quotient -= (remainder >= divisorLanes);
+        memcpy(quotients.data() + j, &quotient, sizeof(quotient));
+    }
+
+    for (j = std::max(first, points.doubleEnd); j < points.count; ++j) {
+        quotients[j] = points.words[j] / divisor;
+    }
+}
+
+// sums[j] = f(points[j]), wrapped around.
+inline void evaluateQueryTable(const QueryTable<long long>& table, const QueryPoints& points, std::vector<long long>& sums) {
+    std::vector<long long> quotients(points.count + QUERY_LANES);
+    sums.assign(points.count, 0);
+
+    size_t first = 0;
+    for (size_t e = 0; e < table.lcms.size(); ++e) {
+        const long long commonMultiple = table.lcms[e];
+        while (first < points.count && points.words[first] < commonMultiple) {
+            first += 1;
+        }
+        if (first == points.count) {
+            break;
+        }
+
+        divideQueryPoints(points, first, commonMultiple, quotients);
+        const unsigned long long factor = (unsigned long long)table.coefficients[e] * (unsigned long long)commonMultiple;
+        for (size_t j = first; j < points.count; ++j) {
+            const unsigned long long q = quotients[j];
+            sums[j] += (long long)(factor * (q * (q + 1) / 2));
+        }
+    }
+}
+
+// sums[j] = f(points[j]), exactly.
+inline void evaluateQueryTable(const QueryTable<long long>& table, const QueryPoints& points, std::vector<mpz_class>& sums) {
+    std::vector<long long> quotients(points.count + QUERY_LANES);
+    std::vector<int128> pending(points.count, 0);
+    sums.assign(points.count, 0);
+    mpz_class scratch;
+
+    size_t first = 0;
+    for (size_t e = 0; e < table.lcms.size(); ++e) {
+        const long long commonMultiple = table.lcms[e];
+        while (first < points.count && points.words[first] < commonMultiple) {
+            first += 1;
+        }
+        if (first == points.count) {
+            break;
+        }
+
+        divideQueryPoints(points, first, commonMultiple, quotients);
+        const long long coefficient = table.coefficients[e];
+        for (size_t j = first; j < points.count; ++j) {
+            const uint128 q = quotients[j];
+            const int128 term = (int128)(commonMultiple * (q * (q + 1) / 2)); // at most T(N) < 2^125
+            int128 scaled, total;
+            if (__builtin_mul_overflow(term, (int128)coefficient, &scaled)) {
+                setFromUint128(scratch, (uint128)term);
+                scratch *= (long)coefficient;
+                sums[j] += scratch;
+            }
+            else if (__builtin_add_overflow(pending[j], scaled, &total)) {
+                addInt128(sums[j], pending[j], scratch);
+                pending[j] = scaled;
+            }
+            else {
+                pending[j] = total;
+            }
+        }
+    }
+
+    for (size_t j = 0; j < points.count; ++j) {
+        addInt128(sums[j], pending[j], scratch);
+    }
+}
+
+// sums[j] = f(points[j]), all in GMP numbers.
+inline void evaluateQueryTable(const QueryTable<mpz_class>& table, const std::vector<mpz_class>& points, std::vector<mpz_class>& sums) {
+    sums.assign(points.size(), 0);
+
+    size_t first = 0;
+    for (size_t e = 0; e < table.lcms.size(); ++e) {
+        const mpz_class& commonMultiple = table.lcms[e];
+        while (first < points.size() && points[first] < commonMultiple) {
+            first += 1;
+        }
+        for (size_t j = first; j < points.size(); ++j) {
+            addSubsetTermTimes(sums[j], points[j], commonMultiple, table.coefficients[e]);
+        }
+    }
+}
+
+// values[j] = f(points[j]); the N of the problem must be the biggest point. tableSize gets the number of entries.
+inline void evaluateQueryPoints(const SubsetProblem<long long>& problem, const std::vector<long long>& points,
+                                std::vector<long long>& values, size_t& tableSize) {
+    const QueryTable<long long> table = buildQueryTable(problem);
+    tableSize = table.lcms.size();
+    evaluateQueryTable(table, QueryPoints(points), values);
+}
+
+inline void evaluateQueryPoints(const SubsetProblem<mpz_class>& problem, const std::vector<mpz_class>& points,
+                                std::vector<mpz_class>& values, size_t& tableSize) {
+    if (!problem.N.fits_slong_p()) {
+        const QueryTable<mpz_class> table = buildQueryTable(problem);
+        tableSize = table.lcms.size();
+        evaluateQueryTable(table, points, values);
+        return;
+    }
+
+    SubsetProblem<long long> wordProblem; // the canonical divisors are at most N
+    wordProblem.N = problem.N.get_si();
+    for (const mpz_class& divisor : problem.divisors) {
+        wordProblem.divisors.push_back(divisor.get_si());
+    }
+    std::vector<long long> wordPoints;
+    for (const mpz_class& point : points) {
+        wordPoints.push_back(point.get_si());
+    }
+
+    const QueryTable<long long> table = buildQueryTable(wordProblem);
+    tableSize = table.lcms.size();
+    evaluateQueryTable(table, QueryPoints(wordPoints), values);
+}
+
+// The answer of every query, from the values at the points (see queryPoints).
+template<typename Number>
+std::vector<Number> answerQueries(const std::vector<IntervalQuery<Number>>& queries,
+                                  const std::vector<Number>& points, const std::vector<Number>& values) {
+    std::vector<Number> answers;
+    for (const IntervalQuery<Number>& query : queries) {
+        const size_t high = std::lower_bound(points.begin(), points.end(), query.high) - points.begin();
+        const size_t low = std::lower_bound(points.begin(), points.end(), Number(query.low - 1)) - points.begin();
+        answers.push_back(values[high] - values[low]);
+    }
+    return answers;
+}
+
+
+#endif // multi_query_cpp
@@ -0,0 +1,146 @@
+#ifndef periodic_cpp
+#define periodic_cpp
+
+#include <algorithm>
+#include <vector>
+
+#include <gmpxx.h>
+
+#include "subset_problem.cpp"
+#include "segmented_sieve.cpp"
+
+// Whether a number is divisible by at least one divisor repeats with period P = lcm(v_1, ..., v_K),
+// so when P is small only [0, P) needs to be sieved, whatever N is.
+//
+// Every n in [0, N] is k * P + x with x in [0, P). With N = q * P + r, x comes up for k = 0 .. q - 1,
+// and for k = q as well if x <= r, so a marked x adds
+//     q * x + P * q * (q - 1) / 2 + [x <= r] * (q * P + x)
+// to the answer (0 is marked, and so adds the multiples of P). That's linear in x, so a range of x only
+// needs the count and the sum of its marked numbers, over the whole range and up to r. The range of a
+// chunk is one of segments of [0, P), sieved like the "sieve" kernel (see segmented_sieve.cpp), and N only
+// comes in at the end: the cost is O(P), and the same for N = 10^6 and N = 10^100.
+
+const long long PERIOD_MAX = 100000000;
+
+// lcm(v_1, ..., v_K), or 0 if that's bigger than PERIOD_MAX or if there are no divisors (then nothing is marked, not even 0).
+template<typename Number>
+long long periodOf(const SubsetProblem<Number>& problem) {
+    if (problem.divisors.empty()) {
+        return 0;
+    }
+
+    long long period = 1;
+    for (const Number& divisor : problem.divisors) {
+        if (divisor > (long)PERIOD_MAX || !lcmWithinLimit(period, toSieveNumber(divisor), PERIOD_MAX, period)) {
+            return 0;
+        }
+    }
+    return period;
+}
+
+template<typename Number>
+struct PeriodicProblem {
+    long long period;
+    SieveProblem sieve; // over [0, period)
+    Number fullPeriods; // q
+    long long remainder; // r
+};
+
+// period is what periodOf returned, and isn't 0.
+template<typename Number>
+PeriodicProblem<Number> buildPeriodicProblem(const SubsetProblem<Number>& problem, long long period) {
+    SubsetProblem<long long> onePeriod;
+    onePeriod.N = period - 1;
+    for (const Number& divisor : problem.divisors) {
+        onePeriod.divisors.push_back(toSieveNumber(divisor));
+    }
+
+    PeriodicProblem<Number> periodic;
+    periodic.period = period;
+    periodic.sieve = buildSieveProblem(onePeriod);
+    periodic.fullPeriods = problem.N / (long)period;
+    periodic.remainder = toSieveNumber(Number(problem.N % (long)period));
+    return periodic;
+}
+
+// The contribution of the marked x of a range, from their count and sum, in total and up to r (see above).
+inline long long periodicTotal(const PeriodicProblem<long long>& periodic,
+                               uint128 count, uint128 sum, uint128 countUpToRemainder, uint128 sumUpToRemainder) {
+    // in unsigned numbers, so this is the true answer modulo 2^64; the other kernels overflow inside T(q) as well
+    // once q * (q + 1) doesn't fit in 63 bits, so for such an N their long long answer is a different one
+    const unsigned long long q = periodic.fullPeriods;
+    const unsigned long long period = periodic.period;
+    const unsigned long long pairs = (q % 2 == 0) ? (q / 2) * (q - 1) : q * ((q - 1) / 2); // q * (q - 1) / 2
+
+    const unsigned long long total = q * (unsigned long long)sum
+                                   + (unsigned long long)count * period * pairs
+                                   + (unsigned long long)countUpToRemainder * q * period
+                                   + (unsigned long long)sumUpToRemainder;
+    return (long long)total;
+}
+
+inline mpz_class periodicTotal(const PeriodicProblem<mpz_class>& periodic,
+                               uint128 count, uint128 sum, uint128 countUpToRemainder, uint128 sumUpToRemainder) {
+    const mpz_class& q = periodic.fullPeriods;
+    const mpz_class pairs = q * (q - 1) / 2;
+    mpz_class partial;
+
+    mpz_class total;
+    setFromUint128(partial, sum);
+    total = q * partial;
+    setFromUint128(partial, count);
+    total += partial * (unsigned long)periodic.period * pairs;
+    setFromUint128(partial, countUpToRemainder);
+    total += partial * q * (unsigned long)periodic.period;
+    setFromUint128(partial, sumUpToRemainder);
+    total += partial;
+    return total;
+}
+
+// The number of segments in [0, P).
+template<typename Number>
+long long periodSegmentCount(const PeriodicProblem<Number>& periodic) {
+    return sieveSegmentCount(periodic.sieve);
+}
+
+// Returns the sum of the terms of the numbers in [1, N] whose residue modulo P is in the segments [segmentStart, segmentEnd).
+template<typename Number>
+Number sumForPeriodRange(const PeriodicProblem<Number>& periodic, long long segmentStart, long long segmentEnd) {
+    const SieveProblem& sieve = periodic.sieve;
+    const long long remainder = periodic.remainder;
+    SieveScratch scratch(sieve, segmentStart);
+
+    uint128 count = 0, sum = 0, countUpToRemainder = 0, sumUpToRemainder = 0;
+    unsigned long long segmentCount;
+    for (long long segment = segmentStart; segment < segmentEnd; ++segment) {
+        const long long low = segment * SIEVE_SEGMENT_SIZE;
+        const long long high = std::min(low + SIEVE_SEGMENT_SIZE, sieve.N + 1);
+        const long long words = markSegment(sieve, low, high, scratch);
+        if (low == 0) {
+            scratch.bits[0] |= 1; // 0 is a multiple of everything, even when P itself is a divisor, which the sieve of [0, P) leaves out
+        }
+        const unsigned long long segmentSum = sumMarkedSegment(sieve, scratch, words, low, segmentCount);
+        count += segmentCount;
+        sum += segmentSum;
+
+        if (high - 1 <= remainder) {
+            countUpToRemainder += segmentCount;
+            sumUpToRemainder += segmentSum;
+        }
+        else if (low <= remainder) { // r is in this segment: drop the marks after it and sum again
+            const long long last = remainder - low;
+            if (last % 64 != 63) {
+                scratch.bits[last / 64] &= (1ULL << (last % 64 + 1)) - 1;
+            }
+            std::fill(scratch.bits.begin() + last / 64 + 1, scratch.bits.begin() + words, 0);
+
+            sumUpToRemainder += sumMarkedSegment(sieve, scratch, words, low, segmentCount);
+            countUpToRemainder += segmentCount;
+        }
+    }
+
+    return periodicTotal(periodic, count, sum, countUpToRemainder, sumUpToRemainder);
+}
+
+
+#endif // periodic_cpp
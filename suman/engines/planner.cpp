@@ -0,0 +1,322 @@
+#ifndef planner_cpp
+#define planner_cpp
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gmpxx.h>
+
+#include "subset_problem.cpp"
+#include "mask_kernels.cpp"
+
+// Picks the kernel, the number type and the number of threads for a problem, from a few probes which
+// cost next to nothing next to the sum itself:
+// - K after the canonicalization, the bits of N and of T(N), which bounds the answer;
+// - the period lcm(v_1, ..., v_K) when it's small (see periodic.cpp) and its number of divisors,
+//   which bounds the number of distinct lcms;
+// - the number of subsets the DFS visits and of lcm steps it tries, estimated by random walks down its
+//   tree (Knuth's estimator: a walk which picks a child with probability p stands for 1 / p times as many
+//   nodes one level down, so the sum over the levels of the products of those 1 / p is an unbiased estimate
+//   of the size of the tree). Without pruning, the j-th of c children has 2^(c - 1 - j) subsets below it,
+//   so the children are picked half the time in that proportion (which makes the estimate exact for such
+//   a tree) and half the time uniformly (which keeps it from going wild on pruned ones);
+// - the fraction of pairs of divisors whose lcm isn't bigger than N, from a sample of pairs.
+//
+// The cost of each kernel is then estimated in lcm steps of 64-bit numbers, with the constants below
+// measured on the inputs from Tests, and the cheapest one wins. The walks use a fixed seed, so every MPI
+// process comes up with the same plan.
+
+enum PlanNumber {
+    PLAN_NUMBER_LONG, // the answer fits in a long long, so it's exact with 64-bit numbers
+    PLAN_NUMBER_CRT,  // "--number crt": the DFS on 64-bit lcms, summed modulo primes (see residue_runner.cpp)
+    PLAN_NUMBER_BIG,  // GMP numbers
+};
+
+struct ProblemProbes {
+    int numDivisors;
+    int bitsOfN;
+    int bitsOfAnswerBound;    // of T(N)
+    long long period;         // see periodOf, 0 if it's too big
+    long long periodDivisors; // the number of divisors of period
+    double marksPerNumber;    // 1 / v_1 + ... + 1 / v_K, for the sieves
+    double estimatedTerms;    // the subsets with an lcm not bigger than N
+    double estimatedAttempts; // the lcm steps of the DFS, the ones which go over N included
+    double compatiblePairs;   // the fraction of pairs of divisors with an lcm not bigger than N
+};
+
+struct Plan {
+    MaskKernel kernel;
+    std::string kernelName;
+    PlanNumber number;
+    int threads; // 1 for the sequential backend
+    double estimatedCost;
+    std::vector<std::pair<std::string, double>> candidates; // every kernel which was considered, with its cost
+};
+
+const unsigned long long PLANNER_SEED = 0x5eed;
+// The walks go on until they've tried PLANNER_STEP_BUDGET lcm steps (a few ms), within these bounds.
+const int PLANNER_MIN_WALKS = 16;
+const int PLANNER_MAX_WALKS = 4096;
+const long long PLANNER_STEP_BUDGET = 1 << 22;
+const int PLANNER_PAIR_SAMPLES = 1024;
+
+// The cost of an lcm step relative to one on 64-bit numbers.
+const double PLAN_COST_CRT = 1.8;     // the same DFS, and a few Montgomery products per term
+const double PLAN_COST_TIERED = 2.9;  // 128-bit words
+const double PLAN_COST_GMP = 12.0;    // mpz_class
+// The sieves, per number of [0, N] (or of the period) and per mark, in the same unit.
+const double PLAN_COST_SIEVE_NUMBER = 0.004;
+const double PLAN_COST_SIEVE_MARK = 0.06;
+// A table kernel step is a lookup and one lcm step, a map step a hash table update.
+const double PLAN_COST_TABLE_STEP = 0.6;
+const double PLAN_COST_MAP_STEP = 3.0;
+
+// Below this many lcm steps (about 10 ms) threads don't pay for themselves.
+const double PLAN_THREADS_MIN_COST = 1e6;
+
+inline long long countDivisors(long long n) {
+    long long count = 1;
+    for (long long p = 2; p * p <= n; ++p) {
+        int exponent = 0;
+        while (n % p == 0) {
+            n /= p;
+            exponent += 1;
+        }
+        count *= exponent + 1;
+    }
+    return (n > 1) ? count * 2 : count;
+}
+
+// Knuth's estimator over the DFS tree of subset_dfs.cpp, see above.
+template<typename Number>
+void estimateDfsTree(const SubsetProblem<Number>& problem, double& terms, double& attempts) {
+    const int numDivisors = problem.numDivisors();
+
+    std::mt19937_64 random(PLANNER_SEED);
+    std::vector<int> children;
+    Number commonMultiple, extended;
+    double totalTerms = 0, totalAttempts = 0;
+    long long steps = 0;
+
+    int walk = 0;
+    for (; walk < PLANNER_MAX_WALKS && (walk < PLANNER_MIN_WALKS || steps < PLANNER_STEP_BUDGET); ++walk) {
+        commonMultiple = 1;
+        double nodesAtLevel = 1;
+        for (int firstFree = 0; ; ) {
+            children.clear();
+            for (int b = firstFree; b < numDivisors; ++b) {
+                if (lcmWithinLimit(commonMultiple, problem.divisors[b], problem.N, extended)) {
+                    children.push_back(b);
+                }
+            }
+            totalAttempts += nodesAtLevel * (numDivisors - firstFree);
+            steps += numDivisors - firstFree;
+            if (children.empty()) {
+                break;
+            }
+
+            const int numChildren = children.size();
+            int j = random() % numChildren;
+            if (random() % 2 == 0) {
+                j = 0; // child j with probability 2^-(j + 1), and the leftover 2^-c on the last one
+                while (j + 1 < numChildren && random() % 2 == 1) {
+                    j += 1;
+                }
+            }
+            const double weighted = (j + 1 < numChildren) ? std::ldexp(1.0, -(j + 1)) : std::ldexp(1.0, -j);
+            nodesAtLevel /= (1.0 / numChildren + weighted) / 2;
+            totalTerms += nodesAtLevel;
+
+            const int b = children[j];
+            lcmWithinLimit(commonMultiple, problem.divisors[b], problem.N, commonMultiple);
+            firstFree = b + 1;
+        }
+    }
+
+    terms = totalTerms / walk;
+    attempts = totalAttempts / walk;
+}
+
+template<typename Number>
+double sampleCompatiblePairs(const SubsetProblem<Number>& problem) {
+    const int numDivisors = problem.numDivisors();
+    if (numDivisors < 2) {
+        return 1;
+    }
+
+    std::mt19937_64 random(PLANNER_SEED);
+    Number commonMultiple;
+    int compatible = 0;
+    for (int sample = 0; sample < PLANNER_PAIR_SAMPLES; ++sample) {
+        const int i = random() % numDivisors;
+        const int j = (i + 1 + random() % (numDivisors - 1)) % numDivisors;
+        if (lcmWithinLimit(problem.divisors[i], problem.divisors[j], problem.N, commonMultiple)) {
+            compatible += 1;
+        }
+    }
+    return (double)compatible / PLANNER_PAIR_SAMPLES;
+}
+
+// The problem must be canonicalized (see canonicalize.cpp).
+inline ProblemProbes probeProblem(const SubsetProblem<mpz_class>& problem) {
+    ProblemProbes probes;
+    probes.numDivisors = problem.numDivisors();
+    probes.bitsOfN = mpz_sizeinbase(problem.N.get_mpz_t(), 2);
+
+    const mpz_class answerBound = problem.N * (problem.N + 1) / 2;
+    probes.bitsOfAnswerBound = mpz_sizeinbase(answerBound.get_mpz_t(), 2);
+
+    probes.period = periodOf(problem);
+    probes.periodDivisors = (probes.period != 0) ? countDivisors(probes.period) : 0;
+
+    probes.marksPerNumber = 0;
+    for (const mpz_class& divisor : problem.divisors) {
+        probes.marksPerNumber += 1 / divisor.get_d();
+    }
+
+    if (problem.N.fits_slong_p()) { // the same walks, on 64-bit numbers
+        SubsetProblem<long long> narrow;
+        narrow.N = problem.N.get_si();
+        for (const mpz_class& divisor : problem.divisors) {
+            narrow.divisors.push_back(divisor.get_si());
+        }
+        estimateDfsTree(narrow, probes.estimatedTerms, probes.estimatedAttempts);
+        probes.compatiblePairs = sampleCompatiblePairs(narrow);
+    }
+    else {
+        estimateDfsTree(problem, probes.estimatedTerms, probes.estimatedAttempts);
+        probes.compatiblePairs = sampleCompatiblePairs(problem);
+    }
+    return probes;
+}
+
+// The number type which the DFS kernels run on: the one the answer fits in, or the residues when N fits
+// in a long long, or else GMP numbers.
+inline PlanNumber dfsNumberFor(const ProblemProbes& probes) {
+    if (probes.bitsOfAnswerBound <= 63) {
+        return PLAN_NUMBER_LONG;
+    }
+    return (probes.bitsOfN <= 63) ? PLAN_NUMBER_CRT : PLAN_NUMBER_BIG;
+}
+
+// The cost of an lcm step of the DFS kernels on that number type.
+inline double dfsStepCost(const ProblemProbes& probes, PlanNumber number, MaskKernel kernel) {
+    switch (number) {
+        case PLAN_NUMBER_LONG:
+            return 1;
+        case PLAN_NUMBER_CRT:
+            return PLAN_COST_CRT;
+        case PLAN_NUMBER_BIG:
+        default:
+            // only the tiered kernel keeps a GMP problem in machine words
+            return (kernel == MASK_KERNEL_TIERED && probes.bitsOfN <= 128) ? PLAN_COST_TIERED : PLAN_COST_GMP;
+    }
+}
+
+// threads is how many the machine has; the plan only uses them if it's worth it.
+inline Plan planFor(const ProblemProbes& probes, int threads) {
+    Plan plan;
+    plan.estimatedCost = INFINITY;
+
+    auto consider = [&](const char *name, MaskKernel kernel, PlanNumber number, double cost) {
+        plan.candidates.push_back(std::make_pair(std::string(name), cost));
+        if (cost < plan.estimatedCost) {
+            plan.kernel = kernel;
+            plan.kernelName = name;
+            plan.number = number;
+            plan.estimatedCost = cost;
+        }
+    };
+
+    const bool fitsMasks = probes.numDivisors <= MASK_MAX_DIVISORS;
+    const PlanNumber dfsNumber = dfsNumberFor(probes);
+    // everything but the DFS kernels needs a long long answer or GMP numbers
+    const PlanNumber exactNumber = (probes.bitsOfAnswerBound <= 63) ? PLAN_NUMBER_LONG : PLAN_NUMBER_BIG;
+
+    if (fitsMasks) {
+        MaskKernel kernel = (dfsNumber == PLAN_NUMBER_BIG) ? MASK_KERNEL_TIERED : MASK_KERNEL_DFS;
+        consider((kernel == MASK_KERNEL_TIERED) ? "tiered" : "dfs", kernel, dfsNumber, probes.estimatedAttempts * dfsStepCost(probes, dfsNumber, kernel));
+
+        if (probes.numDivisors <= 40) { // no pruning at all, every mask is one step
+            const double masks = std::ldexp(1.0, probes.numDivisors);
+            consider("table", MASK_KERNEL_LCM_TABLE, exactNumber, masks * PLAN_COST_TABLE_STEP * dfsStepCost(probes, exactNumber, MASK_KERNEL_LCM_TABLE));
+        }
+
+        // every divisor goes over the table of distinct lcms once
+        const double distinctLcms = (probes.period != 0) ? std::min((double)probes.periodDivisors, probes.estimatedTerms) : probes.estimatedTerms;
+        consider("map", MASK_KERNEL_LCM_MAP, exactNumber, probes.numDivisors * distinctLcms * PLAN_COST_MAP_STEP * dfsStepCost(probes, exactNumber, MASK_KERNEL_LCM_MAP));
+    }
+    else {
+        consider("prefix", MASK_KERNEL_PREFIX_DFS, dfsNumber, probes.estimatedAttempts * dfsStepCost(probes, dfsNumber, MASK_KERNEL_PREFIX_DFS));
+
+        if (dfsNumber != PLAN_NUMBER_CRT) { // the residues only run the plain DFS
+            // the steps to incompatible divisors are dropped by the bitsets, a word at a time
+            const double steps = probes.estimatedTerms + probes.estimatedAttempts * probes.compatiblePairs;
+            consider("clique", MASK_KERNEL_CLIQUE, dfsNumber, steps * dfsStepCost(probes, dfsNumber, MASK_KERNEL_CLIQUE) + probes.estimatedAttempts / 64);
+        }
+    }
+
+    const double costPerNumber = PLAN_COST_SIEVE_NUMBER + probes.marksPerNumber * PLAN_COST_SIEVE_MARK;
+    if (probes.bitsOfN <= 40) { // SIEVE_MAX_N
+        consider("sieve", MASK_KERNEL_SIEVE, exactNumber, std::ldexp(1.0, probes.bitsOfN) * costPerNumber);
+    }
+    if (probes.period != 0) {
+        consider("period", MASK_KERNEL_PERIOD, exactNumber, probes.period * costPerNumber);
+    }
+
+    plan.threads = (plan.estimatedCost >= PLAN_THREADS_MIN_COST) ? threads : 1;
+    return plan;
+}
+
+inline const char *planNumberName(PlanNumber number) {
+    switch (number) {
+        case PLAN_NUMBER_LONG:
+            return "long";
+        case PLAN_NUMBER_CRT:
+            return "crt";
+        case PLAN_NUMBER_BIG:
+        default:
+            return "big";
+    }
+}
+
+inline std::string describeProbes(const ProblemProbes& probes) {
+    char buffer[512];
+    snprintf(buffer,
+             sizeof(buffer),
+             "Probes: K = %i, bits(N) = %i, bits(T(N)) = %i, period = %lli (%lli divisors), marks per number = %.3g,"
+             " DFS ~ %.3g terms and %.3g lcm steps (prune rate %.3g), compatible pairs = %.3g",
+             probes.numDivisors,
+             probes.bitsOfN,
+             probes.bitsOfAnswerBound,
+             probes.period,
+             probes.periodDivisors,
+             probes.marksPerNumber,
+             probes.estimatedTerms,
+             probes.estimatedAttempts,
+             1 - probes.estimatedTerms / std::ldexp(1.0, std::min(probes.numDivisors, 1000)),
+             probes.compatiblePairs);
+
+    return std::string(buffer);
+}
+
+inline std::string describePlan(const Plan& plan) {
+    std::string description = "Plan: estimated costs";
+    char buffer[128];
+    for (const std::pair<std::string, double>& candidate : plan.candidates) {
+        snprintf(buffer, sizeof(buffer), " %s ~ %.3g,", candidate.first.c_str(), candidate.second);
+        description += buffer;
+    }
+
+    snprintf(buffer, sizeof(buffer), " so --kernel %s --number %s with %i thread(s)",
+             plan.kernelName.c_str(), planNumberName(plan.number), plan.threads);
+    return description + buffer;
+}
+
+
+#endif // planner_cpp
@@ -0,0 +1,46 @@
+#ifndef prefix_dfs_cpp
+#define prefix_dfs_cpp
+
+#include <vector>
+
+#include "subset_problem.cpp"
+#include "subset_dfs.cpp"
+
+// Enumeration without masks, for any number of divisors.
+//
+// Every mask kernel indexes the subsets by a 64-bit mask, so it can't go past 62 divisors. Here a
+// work unit is a range of divisor indices instead: the unit [firstStart, firstEnd) holds every subset
+// whose first (lowest index) divisor is in that range, and it's summed by the pruned DFS started from
+// that divisor, which only ever extends a subset with the divisors after it. Together the units [0, K)
+// hold every non-empty subset once.
+//
+// With hundreds of big divisors against a moderate N, most subsets go over N after a few elements,
+// so the DFS only visits a small part of the 2^K subsets, and the recursion is only as deep as the
+// biggest subset which stays under N.
+
+// The most divisors which the mask kernels can index; a bigger problem can only run on the prefix kernel.
+const int MASK_MAX_DIVISORS = 62;
+
+// Returns the sum of the terms of the subsets whose first divisor is in [firstStart, firstEnd).
+template<typename Number>
+Number sumForPrefixRangeDFS(const SubsetProblem<Number>& problem, long long firstStart, long long firstEnd) {
+    const int numDivisors = problem.numDivisors();
+    std::vector<Number> lcmAtDepth(numDivisors + 1);
+    Number sum = 0;
+
+    for (int first = (int)firstStart; first < (int)firstEnd; ++first) {
+        Number& commonMultiple = lcmAtDepth[1];
+        commonMultiple = problem.divisors[first];
+        if (commonMultiple > problem.N) {
+            continue; // only happens if the divisors weren't canonicalized
+        }
+
+        addSubsetTerm(sum, problem.N, commonMultiple, 1);
+        sumSubsetsDFS(problem, first + 1, numDivisors, 1, 1, lcmAtDepth, sum);
+    }
+
+    return sum;
+}
+
+
+#endif // prefix_dfs_cpp
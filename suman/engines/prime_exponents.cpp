@@ -0,0 +1,260 @@
+#ifndef prime_exponents_cpp
+#define prime_exponents_cpp
+
+#include <cstring>
+#include <vector>
+
+#include <gmpxx.h>
+
+#include "subset_problem.cpp"
+#include "subset_dfs.cpp"
+
+// Prime-exponent representation of the lcm.
+//
+// When every divisor factors over a small set of pairwise coprime bases (primes found by trial
+// division, plus at most one leftover cofactor per divisor), the lcm of a subset is the element-wise
+// max of the exponent vectors of its divisors. The vectors are packed one byte per base into a
+// 32-byte SIMD register, so extending a subset is a single vector max instead of a gcd.
+//
+// The lcm itself is kept up to date by multiplying in p^(new exponent - old exponent) for the few
+// bases whose exponent actually grew, so the hot path has no divisions at all apart from the
+// N / lcm needed to evaluate the subset.
+
+const int MAX_PRIME_LANES = 32;
+const unsigned TRIAL_DIVISION_LIMIT = 1 << 16;
+
+typedef unsigned char ExponentLanes __attribute__((vector_size(MAX_PRIME_LANES)));
+
+// result may be the same object as a or b
+inline void maxLanes(const ExponentLanes& a, const ExponentLanes& b, ExponentLanes& result) {
+    result = (a > b) ? a : b;
+}
+
+inline const std::vector<unsigned>& trialDivisionPrimes() {
+    static const std::vector<unsigned> primes = []() {
+        std::vector<bool> composite(TRIAL_DIVISION_LIMIT + 1, false);
+        std::vector<unsigned> result;
+        for (unsigned i = 2; i <= TRIAL_DIVISION_LIMIT; ++i) {
+            if (composite[i]) {
+                continue;
+            }
+
+            result.push_back(i);
+            for (unsigned j = 2 * i; j <= TRIAL_DIVISION_LIMIT; j += i) {
+                composite[j] = true;
+            }
+        }
+        return result;
+    }();
+
+    return primes;
+}
+
+// Divides x by p as many times as possible and returns how many times that was.
+inline int divideOutPrime(long long& x, unsigned p) {
+    int exponent = 0;
+    while (x % p == 0) {
+        x /= p;
+        exponent += 1;
+    }
+    return exponent;
+}
+
+inline int divideOutPrime(mpz_class& x, unsigned p) {
+    int exponent = 0;
+    while (mpz_divisible_ui_p(x.get_mpz_t(), p)) {
+        mpz_divexact_ui(x.get_mpz_t(), x.get_mpz_t(), p);
+        exponent += 1;
+    }
+    return exponent;
+}
+
+template<typename Number>
+struct PrimeExponentBasis {
+    bool applicable;
+    std::vector<Number> bases;                  // pairwise coprime
+    std::vector<ExponentLanes> divisorExponents; // divisorExponents[i][j] = exponent of bases[j] in divisors[i]
+    std::vector<std::vector<Number>> powers;     // powers[j][e] = bases[j]^e, for as long as that's not bigger than N
+};
+
+// Factors the divisors once. The basis is not applicable when a divisor has a leftover cofactor
+// which shares a factor with another one, or when there are more than MAX_PRIME_LANES bases.
+template<typename Number>
+PrimeExponentBasis<Number> buildPrimeExponentBasis(const SubsetProblem<Number>& problem) {
+    PrimeExponentBasis<Number> basis;
+    basis.applicable = false;
+
+    const std::vector<unsigned>& primes = trialDivisionPrimes();
+    std::vector<std::vector<std::pair<int, int>>> factorizations; // (base index, exponent)
+
+    auto findOrAddBase = [&](const Number& base) {
+        for (size_t j = 0; j < basis.bases.size(); ++j) {
+            if (basis.bases[j] == base) {
+                return (int)j;
+            }
+        }
+        basis.bases.push_back(base);
+        return (int)basis.bases.size() - 1;
+    };
+
+    for (const Number& divisor : problem.divisors) {
+        std::vector<std::pair<int, int>> factorization;
+        Number rest = divisor;
+
+        for (unsigned p : primes) {
+            if (rest < (long)p * p) {
+                break; // rest is 1 or a prime
+            }
+
+            int exponent = divideOutPrime(rest, p);
+            if (exponent > 0) {
+                factorization.push_back({findOrAddBase(Number(p)), exponent});
+            }
+        }
+
+        if (rest > 1) {
+            // a prime, or a cofactor without small factors; either way it has to be coprime with every other base
+            int index = findOrAddBase(rest);
+            for (size_t j = 0; j < basis.bases.size(); ++j) {
+                if ((int)j != index && greatestCommonDivisor(rest, basis.bases[j]) != 1) {
+                    return basis;
+                }
+            }
+            factorization.push_back({index, 1});
+        }
+
+        factorizations.push_back(factorization);
+    }
+
+    if ((int)basis.bases.size() > MAX_PRIME_LANES) {
+        return basis;
+    }
+
+    basis.powers.resize(basis.bases.size());
+    for (size_t j = 0; j < basis.bases.size(); ++j) {
+        Number power = 1;
+        do {
+            basis.powers[j].push_back(power);
+        } while (multiplyWithinLimit(power, basis.bases[j], problem.N, power));
+    }
+
+    for (const std::vector<std::pair<int, int>>& factorization : factorizations) {
+        ExponentLanes lanes = {};
+        for (const std::pair<int, int>& factor : factorization) {
+            if (factor.second > 255) {
+                return basis;
+            }
+            lanes[factor.first] = (unsigned char)factor.second;
+        }
+        basis.divisorExponents.push_back(lanes);
+    }
+
+    basis.applicable = true;
+    return basis;
+}
+
+// result = the lcm with exponents merged, given that oldLcm has exponents old.
+// Returns false if it's bigger than N. result may be the same object as oldLcm.
+template<typename Number>
+bool raiseLcm(const PrimeExponentBasis<Number>& basis,
+              const ExponentLanes& old,
+              const ExponentLanes& merged,
+              const Number& oldLcm,
+              const Number& N,
+              Number& result) {
+    unsigned long long oldWords[MAX_PRIME_LANES / 8], mergedWords[MAX_PRIME_LANES / 8];
+    memcpy(oldWords, &old, sizeof(oldWords));
+    memcpy(mergedWords, &merged, sizeof(mergedWords));
+
+    result = oldLcm;
+    const int numWords = ((int)basis.bases.size() + 7) / 8;
+    for (int w = 0; w < numWords; ++w) {
+        unsigned long long changed = oldWords[w] ^ mergedWords[w];
+        while (changed != 0) { // one iteration per base whose exponent grew
+            const int byte = __builtin_ctzll(changed) / 8;
+            const int lane = w * 8 + byte;
+            changed &= ~(0xFFULL << (byte * 8));
+
+            const size_t delta = merged[lane] - old[lane];
+            if (delta >= basis.powers[lane].size()) {
+                return false;
+            }
+            if (!multiplyWithinLimit(result, basis.powers[lane][delta], N, result)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+template<typename Number>
+void sumSubsetsExponentDFS(const SubsetProblem<Number>& problem,
+                           const PrimeExponentBasis<Number>& basis,
+                           int firstBit,
+                           int endBit,
+                           int depth,
+                           int elementCount,
+                           std::vector<ExponentLanes>& lanesAtDepth,
+                           std::vector<Number>& lcmAtDepth,
+                           Number& sum) {
+    for (int b = firstBit; b < endBit; ++b) {
+        ExponentLanes& merged = lanesAtDepth[depth + 1];
+        maxLanes(lanesAtDepth[depth], basis.divisorExponents[b], merged);
+
+        Number& commonMultiple = lcmAtDepth[depth + 1];
+        if (!raiseLcm(basis, lanesAtDepth[depth], merged, lcmAtDepth[depth], problem.N, commonMultiple)) {
+            continue; // every subset containing the current one and b is too big as well
+        }
+
+        addSubsetTerm(sum, problem.N, commonMultiple, elementCount + 1);
+        sumSubsetsExponentDFS(problem, basis, b + 1, endBit, depth + 1, elementCount + 1, lanesAtDepth, lcmAtDepth, sum);
+    }
+}
+
+// Returns the same value as iterating over every mask in [rangeStart, rangeEnd).
+// Falls back to the plain DFS engine when the basis isn't applicable.
+template<typename Number>
+Number sumForMaskRangeExponents(const SubsetProblem<Number>& problem,
+                                const PrimeExponentBasis<Number>& basis,
+                                long long rangeStart,
+                                long long rangeEnd) {
+    if (!basis.applicable) {
+        return sumForMaskRangeDFS(problem, rangeStart, rangeEnd);
+    }
+
+    const int numDivisors = problem.numDivisors();
+    std::vector<ExponentLanes> lanesAtDepth(numDivisors + 1);
+    std::vector<Number> lcmAtDepth(numDivisors + 1);
+    Number sum = 0;
+
+    forEachAlignedBlock(rangeStart, rangeEnd, numDivisors, [&](long long blockStart, int lowBits) {
+        // the bits shared by the whole block
+        ExponentLanes lanes = {};
+        lcmAtDepth[0] = 1;
+        int elementCount = 0;
+        for (int b = lowBits; b < numDivisors; ++b) {
+            if (blockStart & (1LL << b)) {
+                ExponentLanes merged;
+                maxLanes(lanes, basis.divisorExponents[b], merged);
+                if (!raiseLcm(basis, lanes, merged, lcmAtDepth[0], problem.N, lcmAtDepth[0])) {
+                    return;
+                }
+                lanes = merged;
+                elementCount += 1;
+            }
+        }
+
+        if (elementCount > 0) { // the empty subset (mask 0) doesn't count
+            addSubsetTerm(sum, problem.N, lcmAtDepth[0], elementCount);
+        }
+
+        lanesAtDepth[0] = lanes;
+        sumSubsetsExponentDFS(problem, basis, 0, lowBits, 0, elementCount, lanesAtDepth, lcmAtDepth, sum);
+    });
+
+    return sum;
+}
+
+
+#endif // prime_exponents_cpp
@@ -0,0 +1,110 @@
+#ifndef quotient_buckets_cpp
+#define quotient_buckets_cpp
+
+#include <cstddef>
+#include <vector>
+
+#include <gmpxx.h>
+
+// Deferred multiplications for the GMP terms of one chunk.
+//
+// Every term is L * T(q) with q = N / L, and a big L means a small q, shared by many subsets.
+// So instead of a full multiplication per subset, L is added to (or subtracted from) the bucket
+// of its quotient, and each bucket is multiplied by T(q) once, when the chunk is done:
+//     sum of +-L * T(q) = sum over the quotients q of T(q) * (sum of +-L with N / L = q).
+// The buckets are a plain array over the quotients below 2^QUOTIENT_BUCKET_BITS, which is where they
+// repeat. Whether a quotient can be that small is decided from the sizes of N and L before dividing,
+// so the other terms go the usual way without paying for the division twice.
+//
+// The mpz_class addSubsetTerm overloads (see subset_problem.cpp) fill the buckets of the calling
+// thread while sumInQuotientBuckets is running.
+
+const int QUOTIENT_BUCKET_BITS = 16;
+const unsigned long QUOTIENT_BUCKETS = 1UL << QUOTIENT_BUCKET_BITS;
+
+class QuotientBuckets {
+public:
+    QuotientBuckets():
+        sums(QUOTIENT_BUCKETS),
+        used(QUOTIENT_BUCKETS, false) {
+
+    }
+
+    // Returns false (and does nothing) if N / commonMultiple doesn't have a bucket.
+    bool add(const mpz_class& N, const mpz_class& commonMultiple, long long coefficient) {
+        const mpz_srcptr n = N.get_mpz_t();
+        const mpz_srcptr lcm = commonMultiple.get_mpz_t();
+        if (mpz_sizeinbase(n, 2) > mpz_sizeinbase(lcm, 2) + QUOTIENT_BUCKET_BITS) { // q may be 2^QUOTIENT_BUCKET_BITS or more
+            return false;
+        }
+
+        mpz_tdiv_q(quotient.get_mpz_t(), n, lcm);
+        const unsigned long q = mpz_get_ui(quotient.get_mpz_t());
+        if (q >= QUOTIENT_BUCKETS) {
+            return false;
+        }
+
+        if (!used[q]) {
+            used[q] = true;
+            usedQuotients.push_back(q);
+        }
+
+        mpz_ptr bucket = sums[q].get_mpz_t();
+        if (coefficient == 1) {
+            mpz_add(bucket, bucket, lcm);
+        }
+        else if (coefficient == -1) {
+            mpz_sub(bucket, bucket, lcm);
+        }
+        else if (coefficient > 0) {
+            mpz_addmul_ui(bucket, lcm, (unsigned long)coefficient);
+        }
+        else {
+            mpz_submul_ui(bucket, lcm, -(unsigned long)coefficient);
+        }
+        return true;
+    }
+
+    // Adds every bucket times T(its quotient) to sum.
+    void flushInto(mpz_class& sum) const {
+        for (unsigned long q : usedQuotients) {
+            mpz_addmul_ui(sum.get_mpz_t(), sums[q].get_mpz_t(), q * (q + 1) / 2); // q < 2^16, so T(q) fits
+        }
+    }
+
+    size_t size() const {
+        return usedQuotients.size();
+    }
+
+private:
+    std::vector<mpz_class> sums; // indexed by the quotient
+    std::vector<bool> used;
+    std::vector<unsigned long> usedQuotients;
+    mpz_class quotient; // scratch
+};
+
+// The buckets of the calling thread, or NULL when the terms are added right away.
+inline QuotientBuckets*& threadBucketsSlot() {
+    static thread_local QuotientBuckets *current = NULL;
+    return current;
+}
+
+// Evaluates one chunk with its terms collected in fresh buckets of the calling thread,
+// which are multiplied out into the returned sum at the end.
+// The buckets live inside the call, so this can run inside sumInChunkArena.
+template<typename SumFunction>
+mpz_class sumInQuotientBuckets(SumFunction computeSum, size_t& numBuckets) {
+    QuotientBuckets buckets;
+    QuotientBuckets *threadBuckets = threadBucketsSlot();
+    threadBucketsSlot() = &buckets;
+
+    mpz_class sum = computeSum();
+    threadBucketsSlot() = threadBuckets;
+
+    buckets.flushInto(sum);
+    numBuckets = buckets.size();
+    return sum;
+}
+
+
+#endif // quotient_buckets_cpp
@@ -0,0 +1,201 @@
+#ifndef residue_runner_cpp
+#define residue_runner_cpp
+
+#include <vector>
+
+#include <gmpxx.h>
+
+#include "subset_problem.cpp"
+#include "subset_dfs.cpp"
+#include "tiered.cpp"
+#include "prefix_dfs.cpp"
+#include "residues.cpp"
+
+// Exact answers for GMP problems without GMP in the loop: the tiered DFS (see tiered.cpp) walks the
+// subsets with the lcms in machine words, and every term goes into the residues of the chunk
+// (see residues.cpp) instead of an mpz_class. So a chunk costs the same whatever the size of its
+// partial sum, and its result is a few words. Only for an N below 2^128.
+//
+// A term L * T(q) is taken apart as L / R times T(q) / R (T(q) is exact in 128 bits unless q is over
+// 2^64 or so, then it's a Montgomery product of its two factors), which gives L * T(q) / R^3 mod p.
+// Every term of a chunk has that same factor, so it's only taken out at the end.
+//
+// When N fits in a long long, the plain DFS (see subset_dfs.cpp) walks the subsets instead,
+// with its 64-bit lcms, and only the terms go into the residues.
+
+class ResidueAccumulator {
+public:
+    ResidueAccumulator():
+        moduli(residueModuli()) {
+
+        for (int i = 0; i < CRT_MAX_MODULI; ++i) {
+            sums[i] = 0;
+        }
+    }
+
+    // Adds (or subtracts, for subsets of even size) the sum of the multiples of commonMultiple in [1, N].
+    void addSubsetTerm(const SubsetProblem<mpz_class>& problem,
+                       const TieredProblem& tiered,
+                       uint128 commonMultiple,
+                       int elementCount) {
+        addTerm(commonMultiple, divide128(tiered.N, commonMultiple), elementCount);
+    }
+
+    // Adds (or subtracts) commonMultiple * T(subsetCardinality).
+    void addTerm(uint128 commonMultiple, uint128 subsetCardinality, int elementCount) {
+        // T(q) = a * b with one of q, q + 1 halved; (q + 1) / 2 is written so that it can't overflow
+        uint128 a = subsetCardinality, b;
+        if (a % 2 == 0) {
+            a /= 2;
+            b = subsetCardinality + 1;
+        }
+        else {
+            b = (subsetCardinality >> 1) + 1;
+        }
+
+        uint128 triangular;
+        const bool triangularFits = !__builtin_mul_overflow(a, b, &triangular);
+
+        for (int i = 0; i < moduli.count; ++i) {
+            const MontgomeryModulus& m = moduli.moduli[i];
+
+            unsigned long long reducedTriangular; // T(q) / R
+            if (triangularFits) {
+                reducedTriangular = m.reduceWide(triangular);
+            }
+            else {
+                // (a / R) * (b / R) / R * R^3 / R
+                reducedTriangular = m.multiply(m.multiply(m.reduceWide(a), m.reduceWide(b)), m.rCubed);
+            }
+
+            const unsigned long long term = m.multiply(m.reduceWide(commonMultiple), reducedTriangular);
+            if (elementCount & 1) { // odd
+                sums[i] = m.add(sums[i], term);
+            }
+            else { // even
+                sums[i] = m.subtract(sums[i], term);
+            }
+        }
+    }
+
+    ResidueSum total() const {
+        ResidueSum result;
+        for (int i = 0; i < moduli.count; ++i) {
+            const MontgomeryModulus& m = moduli.moduli[i];
+            result.residues[i] = m.multiply(sums[i], m.rFourth); // sums[i] * R^3
+        }
+        return result;
+    }
+
+private:
+    const ResidueModuli moduli; // a copy, so that the stores to sums can't alias it
+    unsigned long long sums[CRT_MAX_MODULI]; // the terms over R^3
+};
+
+// The subset_dfs.cpp engines call this one on the 64-bit problem.
+inline void addSubsetTerm(ResidueAccumulator& sum, long long N, long long commonMultiple, int elementCount) {
+    sum.addTerm((unsigned long long)commonMultiple, (unsigned long long)(N / commonMultiple), elementCount);
+}
+
+// Whether the residue runner can take the problem.
+inline bool fitsResidueRunner(const SubsetProblem<mpz_class>& problem) {
+    return fitsUint128(problem.N);
+}
+
+// Runs the residue DFS over ranges of one problem, like MaskKernelRunner does for the kernels:
+// over masks, or over first divisors (see prefix_dfs.cpp) when there are too many divisors for masks.
+// The moduli have to be installed first.
+class ResidueRunner {
+public:
+    typedef ResidueSum Sum;
+
+    explicit ResidueRunner(const SubsetProblem<mpz_class>& problem):
+        problem(problem),
+        tiered(buildTieredProblem(problem)),
+        inWords(fitsInWords(problem)) {
+
+        if (inWords) {
+            wordProblem.N = problem.N.get_si();
+            for (const mpz_class& divisor : problem.divisors) {
+                wordProblem.divisors.push_back(divisor.get_si());
+            }
+        }
+    }
+
+    long long rangeLimit() const {
+        if (splitsFirstDivisors()) {
+            return problem.numDivisors();
+        }
+        return 1LL << problem.numDivisors();
+    }
+
+    ResidueSum sumForRange(long long rangeStart, long long rangeEnd) const {
+        ResidueAccumulator sum;
+        if (inWords) {
+            sumWordRange(rangeStart, rangeEnd, sum);
+            return sum.total();
+        }
+        if (!splitsFirstDivisors()) {
+            sumMaskRangeTieredInto(problem, tiered, rangeStart, rangeEnd, sum);
+            return sum.total();
+        }
+
+        const int numDivisors = problem.numDivisors();
+        std::vector<uint128> lcmAtDepth(numDivisors + 1);
+        for (int first = (int)rangeStart; first < (int)rangeEnd; ++first) {
+            if (!lcmWithinLimit(tiered, 1, first, lcmAtDepth[1])) {
+                continue; // only happens if the divisors weren't canonicalized
+            }
+
+            sum.addSubsetTerm(problem, tiered, lcmAtDepth[1], 1);
+            sumSubsetsTieredDFS(problem, tiered, first + 1, numDivisors, 1, 1, lcmAtDepth, sum);
+        }
+        return sum.total();
+    }
+
+private:
+    const SubsetProblem<mpz_class>& problem;
+    TieredProblem tiered;
+    const bool inWords; // N fits in a long long, so wordProblem is the same problem with 64-bit numbers
+    SubsetProblem<long long> wordProblem;
+
+    bool splitsFirstDivisors() const {
+        return problem.numDivisors() > MASK_MAX_DIVISORS;
+    }
+
+    static bool fitsInWords(const SubsetProblem<mpz_class>& problem) {
+        if (!problem.N.fits_slong_p()) {
+            return false;
+        }
+        for (const mpz_class& divisor : problem.divisors) {
+            if (!divisor.fits_slong_p()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void sumWordRange(long long rangeStart, long long rangeEnd, ResidueAccumulator& sum) const {
+        const int numDivisors = wordProblem.numDivisors();
+        std::vector<long long> lcmAtDepth(numDivisors + 1);
+        if (!splitsFirstDivisors()) {
+            forEachAlignedBlock(rangeStart, rangeEnd, numDivisors, [&](long long blockStart, int lowBits) {
+                sumMaskBlockDFS(wordProblem, blockStart, lowBits, lcmAtDepth, sum);
+            });
+            return;
+        }
+
+        for (int first = (int)rangeStart; first < (int)rangeEnd; ++first) {
+            lcmAtDepth[1] = wordProblem.divisors[first];
+            if (lcmAtDepth[1] > wordProblem.N) {
+                continue; // only happens if the divisors weren't canonicalized
+            }
+
+            addSubsetTerm(sum, wordProblem.N, lcmAtDepth[1], 1);
+            sumSubsetsDFS(wordProblem, first + 1, numDivisors, 1, 1, lcmAtDepth, sum);
+        }
+    }
+};
+
+
+#endif // residue_runner_cpp
@@ -0,0 +1,167 @@
+#ifndef residues_cpp
+#define residues_cpp
+
+#include <ostream>
+
+#include <gmpxx.h>
+
+// Sums kept modulo several primes just below 2^62 instead of as GMP integers.
+//
+// The answer is in [0, T(N)] (it's a sum of distinct numbers from [1, N]), so once the product M of
+// the moduli is bigger than T(N), the residues of the answer pin it down (Chinese remainder theorem).
+// The partial sums on the way may be anything, but they only ever get added, so each chunk
+// keeps one word per modulus and the exact value is only rebuilt once, from the final residues.
+//
+// The products are Montgomery products, so there's no division by a modulus anywhere:
+// with R = 2^64, redc(x) = x / R mod p for any x < p * R.
+
+typedef unsigned __int128 uint128;
+
+const int CRT_MAX_MODULI = 5; // enough for every N below 2^128
+
+const unsigned long long CRT_PRIMES[CRT_MAX_MODULI] = {
+    0x3fffffffffffffc7ULL,
+    0x3fffffffffffffa9ULL,
+    0x3fffffffffffff8bULL,
+    0x3fffffffffffff71ULL,
+    0x3fffffffffffff67ULL,
+};
+
+// Arithmetic modulo an odd p < 2^63, on numbers in [0, p).
+struct MontgomeryModulus {
+    unsigned long long p;
+    unsigned long long negativeInverse; // -1 / p mod R
+    unsigned long long rCubed;          // R^3 mod p
+    unsigned long long rFourth;         // R^4 mod p
+
+    explicit MontgomeryModulus(unsigned long long p = 1):
+        p(p) {
+
+        unsigned long long inverse = p; // right in the lowest 3 bits for any odd p; each step doubles that
+        for (int i = 0; i < 5; ++i) {
+            inverse *= 2 - p * inverse;
+        }
+        negativeInverse = -inverse;
+
+        const unsigned long long r = (unsigned long long)(((uint128)1 << 64) % p);
+        const unsigned long long rSquared = (unsigned long long)((uint128)r * r % p);
+        rCubed = (unsigned long long)((uint128)rSquared * r % p);
+        rFourth = (unsigned long long)((uint128)rCubed * r % p);
+    }
+
+    // x / R mod p, for x < p * R
+    unsigned long long redc(uint128 x) const {
+        const unsigned long long m = (unsigned long long)x * negativeInverse;
+        const unsigned long long t = (unsigned long long)((x + (uint128)m * p) >> 64);
+        return (t >= p) ? t - p : t;
+    }
+
+    unsigned long long multiply(unsigned long long a, unsigned long long b) const {
+        return redc((uint128)a * b);
+    }
+
+    // x / R mod p for any 128-bit x: x / R = high + low / R
+    unsigned long long reduceWide(uint128 x) const {
+        const unsigned long long high = (unsigned long long)(x >> 64);
+        const unsigned long long low = redc((unsigned long long)x);
+        return (high == 0) ? low : add(low, high % p);
+    }
+
+    unsigned long long add(unsigned long long a, unsigned long long b) const {
+        const unsigned long long s = a + b;
+        return (s >= p) ? s - p : s;
+    }
+
+    unsigned long long subtract(unsigned long long a, unsigned long long b) const {
+        return (a >= b) ? a - b : a + p - b;
+    }
+};
+
+// The moduli of this process. They only depend on N, so every MPI process installs the same ones.
+struct ResidueModuli {
+    int count;
+    MontgomeryModulus moduli[CRT_MAX_MODULI];
+};
+
+inline ResidueModuli& residueModuli() {
+    static ResidueModuli moduli; // no moduli until installResidueModuli
+    return moduli;
+}
+
+// Picks as many of the CRT primes as an answer up to bound needs. Returns false if all of them aren't enough.
+inline bool installResidueModuli(const mpz_class& bound) {
+    ResidueModuli& installed = residueModuli();
+    installed.count = 0;
+
+    mpz_class product = 1;
+    while (product <= bound) {
+        if (installed.count == CRT_MAX_MODULI) {
+            return false;
+        }
+
+        const unsigned long long p = CRT_PRIMES[installed.count];
+        installed.moduli[installed.count] = MontgomeryModulus(p);
+        installed.count += 1;
+        product *= mpz_class((unsigned long)p);
+    }
+    return true;
+}
+
+// Sums modulo p only, for an answer which is only wanted modulo p. p must be odd (and below 2^63).
+inline void installResidueModulus(unsigned long long p) {
+    ResidueModuli& installed = residueModuli();
+    installed.moduli[0] = MontgomeryModulus(p);
+    installed.count = 1;
+}
+
+// A sum as its residues modulo the installed moduli: a fixed-size array of words,
+// which goes through the backends (and MPI) like any other number.
+struct ResidueSum {
+    unsigned long long residues[CRT_MAX_MODULI];
+
+    // only 0 converts; the backends start their sums from it
+    ResidueSum(int zero = 0) {
+        for (int i = 0; i < CRT_MAX_MODULI; ++i) {
+            residues[i] = 0;
+        }
+    }
+
+    ResidueSum& operator+=(const ResidueSum& other) {
+        const ResidueModuli& installed = residueModuli();
+        for (int i = 0; i < installed.count; ++i) {
+            residues[i] = installed.moduli[i].add(residues[i], other.residues[i]);
+        }
+        return *this;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const ResidueSum& sum) {
+    out << '[';
+    for (int i = 0; i < residueModuli().count; ++i) {
+        out << (i > 0 ? " " : "") << sum.residues[i];
+    }
+    return out << ']';
+}
+
+// The number in [0, M) with these residues.
+inline mpz_class reconstructResidues(const ResidueSum& sum) {
+    const ResidueModuli& installed = residueModuli();
+
+    // Garner: x = x_0 + p_0 * (x_1 + p_1 * (...)), one modulus at a time
+    mpz_class result = 0, product = 1, modulus, digit, inverse;
+    for (int i = 0; i < installed.count; ++i) {
+        modulus = mpz_class((unsigned long)installed.moduli[i].p);
+
+        digit = mpz_class((unsigned long)sum.residues[i]) - result;
+        mpz_invert(inverse.get_mpz_t(), product.get_mpz_t(), modulus.get_mpz_t());
+        digit = digit * inverse;
+        mpz_mod(digit.get_mpz_t(), digit.get_mpz_t(), modulus.get_mpz_t());
+
+        result += digit * product;
+        product *= modulus;
+    }
+    return result;
+}
+
+
+#endif // residues_cpp
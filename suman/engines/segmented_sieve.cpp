@@ -0,0 +1,188 @@
+#ifndef segmented_sieve_cpp
+#define segmented_sieve_cpp
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <gmpxx.h>
+
+#include "subset_problem.cpp"
+#include "tiered.cpp"
+
+// The answer straight from its definition, for a small N: every multiple of every divisor in [1, N]
+// is marked in a bitset, and the marked numbers are added up. That's about N / 64 words and
+// N / v_1 + ... + N / v_K marks, whatever the number of divisors and however few subsets get pruned,
+// so it beats the subset kernels when N is modest and K is big.
+//
+// [0, N] is cut into segments of 2^SIEVE_SEGMENT_BITS numbers, whose bitset stays in the L1 / L2 cache
+// while every divisor marks its multiples in it. The range of a chunk is one of segment indices, so
+// the backends split the numbers between threads and processes like they split masks. Every divisor
+// keeps its next multiple from one segment to the next, so only the first segment of a chunk divides.
+// A divisor d below 64 would mark most words several times over, so it ORs in whole words instead:
+// bit i of word g is set when 64 * g + i is a multiple of d, which only depends on g mod d, so the
+// d possible words are computed once.
+// The marked numbers are summed with vector instructions (see sieve_lanes.cpp): AVX2 when the CPU has it, SSE2 otherwise.
+//
+// The sum of a segment fits in 64 bits and the sum of a chunk in 128 bits, which gives the exact answer
+// for mpz_class and the true answer modulo 2^64 for long long. For an N past about 3 * 10^9 that's not the
+// long long answer of the subset kernels, whose T(q) overflows on its own.
+
+const int SIEVE_SEGMENT_BITS = 18; // a 32 KB bitset
+const long long SIEVE_SEGMENT_SIZE = 1LL << SIEVE_SEGMENT_BITS;
+const long long SIEVE_SEGMENT_WORDS = SIEVE_SEGMENT_SIZE / 64;
+
+// Past this the sieve would take ages anyway, and SIEVE_SEGMENT_SIZE numbers up to it sum to less than 2^64.
+const long long SIEVE_MAX_N = 1LL << 40;
+
+namespace sieve_sse2 {
+const int SIEVE_LANES = 2;
+#include "sieve_lanes.cpp"
+}
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+namespace sieve_avx2 {
+const int SIEVE_LANES = 4;
+#include "sieve_lanes.cpp"
+}
+#pragma GCC pop_options
+
+const long long SIEVE_PATTERN_LIMIT = 64; // the divisors below it are marked by word patterns
+
+// The problem in 64-bit numbers.
+struct SieveProblem {
+    long long N;
+    std::vector<long long> divisors; // the ones from SIEVE_PATTERN_LIMIT up to N
+    std::vector<std::vector<unsigned long long>> patterns; // patterns[j][g % d] is word g of the multiples of the j-th smaller divisor d
+    bool avx2;
+};
+
+inline std::vector<unsigned long long> multiplePattern(long long divisor) {
+    std::vector<unsigned long long> pattern(divisor, 0);
+    for (long long multiple = 0; multiple < 64 * divisor; multiple += divisor) {
+        pattern[multiple / 64] |= 1ULL << (multiple % 64);
+    }
+    return pattern;
+}
+
+template<typename Number>
+bool fitsSieve(const SubsetProblem<Number>& problem) {
+    return problem.N <= (long)SIEVE_MAX_N;
+}
+
+inline long long toSieveNumber(long long x) {
+    return x;
+}
+
+inline long long toSieveNumber(const mpz_class& x) {
+    return x.get_si();
+}
+
+// The problem must fit the sieve.
+template<typename Number>
+SieveProblem buildSieveProblem(const SubsetProblem<Number>& problem) {
+    SieveProblem sieve;
+    sieve.N = toSieveNumber(problem.N);
+    for (const Number& divisor : problem.divisors) {
+        if (divisor < (long)SIEVE_PATTERN_LIMIT) {
+            sieve.patterns.push_back(multiplePattern(toSieveNumber(divisor)));
+        }
+        else if (divisor <= problem.N) {
+            sieve.divisors.push_back(toSieveNumber(divisor));
+        }
+    }
+    sieve.avx2 = __builtin_cpu_supports("avx2");
+    return sieve;
+}
+
+// The number of segments in [0, N].
+inline long long sieveSegmentCount(const SieveProblem& sieve) {
+    return sieve.N / SIEVE_SEGMENT_SIZE + 1;
+}
+
+inline void setFromSieveSum(long long& result, uint128 sum) {
+    result = (long long)(unsigned long long)sum; // the answer modulo 2^64
+}
+
+inline void setFromSieveSum(mpz_class& result, uint128 sum) {
+    setFromUint128(result, sum);
+}
+
+// The state of a walk over consecutive segments: the bitset of the current one and the next multiple of every divisor.
+struct SieveScratch {
+    std::vector<unsigned long long> bits;
+    std::vector<long long> nextMultiple;
+
+    SieveScratch(const SieveProblem& sieve, long long firstSegment):
+        bits(SIEVE_SEGMENT_WORDS),
+        nextMultiple(sieve.divisors.size()) {
+
+        const long long rangeStart = firstSegment * SIEVE_SEGMENT_SIZE;
+        for (int i = 0; i < (int)sieve.divisors.size(); ++i) {
+            const long long divisor = sieve.divisors[i];
+            nextMultiple[i] = (rangeStart + divisor - 1) / divisor * divisor;
+        }
+    }
+};
+
+// Marks the multiples in [low, high) of the segment starting at low, which must come right after the last
+// segment marked with this scratch. Returns the number of words to sum (the used ones, rounded up for the vector lanes).
+inline long long markSegment(const SieveProblem& sieve, long long low, long long high, SieveScratch& scratch) {
+    std::vector<unsigned long long>& bits = scratch.bits;
+    const long long usedWords = (high - low + 63) / 64;
+    const long long words = (usedWords + 7) / 8 * 8;
+    std::fill(bits.begin(), bits.begin() + words, 0);
+
+    for (const std::vector<unsigned long long>& pattern : sieve.patterns) {
+        const long long divisor = pattern.size();
+        long long phase = (low / 64) % divisor;
+        for (long long k = 0; k < usedWords; ++k) {
+            bits[k] |= pattern[phase];
+            phase = (phase + 1 == divisor) ? 0 : phase + 1;
+        }
+    }
+    if ((high - low) % 64 != 0) { // the patterns go past high in the last word
+        bits[usedWords - 1] &= (1ULL << ((high - low) % 64)) - 1;
+    }
+
+    for (int i = 0; i < (int)sieve.divisors.size(); ++i) {
+        const long long divisor = sieve.divisors[i];
+        long long offset = scratch.nextMultiple[i] - low;
+        for (; offset < high - low; offset += divisor) {
+            bits[offset >> 6] |= 1ULL << (offset & 63);
+        }
+        scratch.nextMultiple[i] = low + offset;
+    }
+
+    return words;
+}
+
+// The sum (and count) of the marked numbers of the segment starting at low.
+inline unsigned long long sumMarkedSegment(const SieveProblem& sieve, const SieveScratch& scratch, long long words, long long low, unsigned long long& count) {
+    if (sieve.avx2) {
+        return sieve_avx2::sumMarkedValues(scratch.bits.data(), words, low, count);
+    }
+    return sieve_sse2::sumMarkedValues(scratch.bits.data(), words, low, count);
+}
+
+// Returns the sum of the numbers in the segments [segmentStart, segmentEnd) which are divisible by at least one divisor.
+template<typename Number>
+Number sumForSegmentRange(const SieveProblem& sieve, long long segmentStart, long long segmentEnd) {
+    SieveScratch scratch(sieve, segmentStart);
+
+    uint128 sum = 0;
+    unsigned long long count;
+    for (long long segment = segmentStart; segment < segmentEnd; ++segment) {
+        const long long low = segment * SIEVE_SEGMENT_SIZE;
+        const long long high = std::min(low + SIEVE_SEGMENT_SIZE, sieve.N + 1);
+        const long long words = markSegment(sieve, low, high, scratch);
+        sum += sumMarkedSegment(sieve, scratch, words, low, count); // 0 may be marked, but adds nothing
+    }
+
+    Number result;
+    setFromSieveSum(result, sum);
+    return result;
+}
+
+#endif // segmented_sieve_cpp
@@ -0,0 +1,63 @@
+// The summing loop of segmented_sieve.cpp, without an include guard: it is included once per
+// instruction set, inside a namespace which defines SIEVE_LANES and under a matching
+// #pragma GCC target, like simd_lanes.cpp.
+//
+// There's no vector popcount before AVX-512, so the bits are counted per byte with the usual
+// shifts and masks, and a byte count only gets summed over its word when it can't overflow a byte.
+
+typedef unsigned long long SieveWords __attribute__((vector_size(SIEVE_LANES * sizeof(unsigned long long))));
+
+// The number of set bits of every byte.
+inline SieveWords byteCounts(SieveWords x) {
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    return (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+}
+
+// The sum of the bytes of every lane, which must be below 256.
+inline SieveWords byteSums(SieveWords x) {
+    x += x >> 32;
+    x += x >> 16;
+    x += x >> 8;
+    return x & 0xFF;
+}
+
+// The sum of base + 64 * k + i over the set bits i of words[k], for k in [0, numWords); count gets the number of those bits.
+// numWords must be a multiple of SIEVE_LANES, and the sum must fit in 64 bits.
+inline unsigned long long sumMarkedValues(const unsigned long long *words, long long numWords, unsigned long long base, unsigned long long& count) {
+    SieveWords counts = {}, countsTimesWord = {}, bitIndices = {};
+    SieveWords wordIndex;
+    for (int i = 0; i < SIEVE_LANES; ++i) {
+        wordIndex[i] = i;
+    }
+
+    for (long long k = 0; k < numWords; k += SIEVE_LANES) {
+        SieveWords lanes;
+        memcpy(&lanes, words + k, sizeof(lanes));
+
+        const SieveWords bytes = byteCounts(lanes);
+        const SieveWords count = byteSums(bytes);
+        counts += count;
+        countsTimesWord += count * wordIndex;
+
+        // the index of a bit in its word: its index in its byte (at most 0 + 1 + ... + 7 = 28 per byte),
+        // plus 8, 16 and 32 for the bits of the byte's index
+        const SieveWords inByte = byteCounts(lanes & 0xAAAAAAAAAAAAAAAAULL)
+                                + 2 * byteCounts(lanes & 0xCCCCCCCCCCCCCCCCULL)
+                                + 4 * byteCounts(lanes & 0xF0F0F0F0F0F0F0F0ULL);
+        bitIndices += byteSums(inByte)
+                    + 8 * byteSums(bytes & 0xFF00FF00FF00FF00ULL)
+                    + 16 * byteSums(bytes & 0xFFFF0000FFFF0000ULL)
+                    + 32 * byteSums(bytes & 0xFFFFFFFF00000000ULL);
+
+        wordIndex += SIEVE_LANES;
+    }
+
+    unsigned long long sum = 0;
+    count = 0;
+    for (int i = 0; i < SIEVE_LANES; ++i) {
+        sum += base * counts[i] + 64 * countsTimesWord[i] + bitIndices[i];
+        count += counts[i];
+    }
+    return sum;
+}
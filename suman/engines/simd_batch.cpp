@@ -0,0 +1,106 @@
+#ifndef simd_batch_cpp
+#define simd_batch_cpp
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <gmpxx.h>
+
+#include "subset_problem.cpp"
+#include "lcm_table.cpp"
+
+// The lcm table kernel (see lcm_table.cpp) for 64-bit numbers, filling several table entries per
+// step with vector instructions, for dense inputs where nothing gets pruned anyway and the time goes
+// into the divisions of every lcm and every N / L.
+//
+// The entries with the same highest bit all extend their parent with the same divisor d, so
+// consecutive parents go through the same operations in the lanes of a vector:
+// - gcd(parent, d) = gcd(parent mod d, d), the latter with a binary gcd which runs until every lane is done;
+// - lcm = parent * (d / gcd), where a lane is over N if the product, estimated in double precision,
+//   is over 2^62 or if its exact (then not wrapped) low 64 bits are bigger than N;
+// - the sum of the multiples is L * T(N / L), added or subtracted by the parity of the lane's mask.
+// There is no 64-bit vector division, so every quotient is estimated in double precision and then
+// corrected with integer multiplications (see divideLanes). Both tricks need some headroom, so N < 2^61.
+//
+// The lanes are GCC vector extensions, compiled once for AVX-512 (8 lanes) and once for AVX2 (4 lanes)
+// from simd_lanes.cpp. The widest set which the CPU has is picked at run time; without AVX2,
+// or for a bigger N, the scalar lcm table runs instead. The results are the same either way.
+
+const long long SIMD_MAX_N = (1LL << 61) - 1;
+
+enum SimdLevel {
+    SIMD_LEVEL_NONE,
+    SIMD_LEVEL_AVX2,
+    SIMD_LEVEL_AVX512,
+};
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+namespace simd_avx2 {
+const int SIMD_LANES = 4;
+#include "simd_lanes.cpp"
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512dq")
+namespace simd_avx512 {
+const int SIMD_LANES = 8;
+#include "simd_lanes.cpp"
+}
+#pragma GCC pop_options
+
+// The vector kernel which can run on this CPU for this problem.
+inline SimdLevel simdLevelFor(const SubsetProblem<long long>& problem) {
+    if (problem.N > SIMD_MAX_N) {
+        return SIMD_LEVEL_NONE;
+    }
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")) {
+        return SIMD_LEVEL_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return SIMD_LEVEL_AVX2;
+    }
+    return SIMD_LEVEL_NONE;
+}
+
+inline SimdLevel simdLevelFor(const SubsetProblem<mpz_class>& problem) {
+    return SIMD_LEVEL_NONE;
+}
+
+// Returns the same value as iterating over every mask in [rangeStart, rangeEnd).
+// level is what simdLevelFor returned; for SIMD_LEVEL_NONE the scalar lcm table is used.
+inline long long sumForMaskRangeSimd(const SubsetProblem<long long>& problem, SimdLevel level, long long rangeStart, long long rangeEnd) {
+    if (level == SIMD_LEVEL_NONE) {
+        return sumForMaskRangeLcmTable(problem, rangeStart, rangeEnd);
+    }
+
+    const int numDivisors = problem.numDivisors();
+    const int maxTableBits = std::min(lcmTableBits<long long>(), numDivisors);
+    std::vector<long long> table(1 << maxTableBits);
+    long long sum = 0;
+
+    forEachAlignedBlock(rangeStart, rangeEnd, numDivisors, [&](long long blockStart, int lowBits) {
+        const int tableBits = std::min(lowBits, maxTableBits);
+        const long long blockEnd = blockStart + (1LL << lowBits);
+        for (long long tableStart = blockStart; tableStart < blockEnd; tableStart += (1LL << tableBits)) {
+            if (level == SIMD_LEVEL_AVX512) {
+                sum += simd_avx512::sumMaskBlockSimd(problem, tableStart, tableBits, table);
+            }
+            else {
+                sum += simd_avx2::sumMaskBlockSimd(problem, tableStart, tableBits, table);
+            }
+        }
+    });
+
+    return sum;
+}
+
+// GMP numbers don't fit in the lanes.
+inline mpz_class sumForMaskRangeSimd(const SubsetProblem<mpz_class>& problem, SimdLevel level, long long rangeStart, long long rangeEnd) {
+    return sumForMaskRangeLcmTable(problem, rangeStart, rangeEnd);
+}
+
+
+#endif // simd_batch_cpp
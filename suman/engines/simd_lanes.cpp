@@ -0,0 +1,144 @@
+// The body of the vector kernel of simd_batch.cpp, without an include guard: it is included once
+// per instruction set, inside a namespace which defines SIMD_LANES and under a matching
+// #pragma GCC target, so that GCC compiles the vector operations below to instructions of that set.
+
+typedef long long SimdWords __attribute__((vector_size(SIMD_LANES * sizeof(long long))));
+typedef unsigned long long SimdUnsignedWords __attribute__((vector_size(SIMD_LANES * sizeof(long long))));
+typedef double SimdDoubles __attribute__((vector_size(SIMD_LANES * sizeof(double))));
+
+inline SimdWords broadcastLanes(long long value) {
+    return SimdWords{} + value;
+}
+
+// a * b, wrapping around like the scalar code does, without the undefined behavior of signed overflow.
+inline SimdWords multiplyLanes(SimdWords a, SimdWords b) {
+    return (SimdWords)((SimdUnsignedWords)a * (SimdUnsignedWords)b);
+}
+
+inline bool anyLane(SimdWords lanes) {
+    long long any = 0;
+    for (int i = 0; i < SIMD_LANES; ++i) {
+        any |= lanes[i];
+    }
+    return any != 0;
+}
+
+// The number of trailing zero bits of every lane (and some count in [0, 63] for a lane of 0).
+// The lowest set bit is a power of two; the 32-bit half which holds it is placed in the mantissa of
+// 2^52, so subtracting 2^52 leaves it as a double whose exponent is the count. Unlike a conversion
+// from 64-bit integers, this doesn't need AVX-512.
+inline SimdWords trailingZerosLanes(SimdWords lanes) {
+    const SimdWords lowestBit = lanes & -lanes;
+    const SimdWords inHighHalf = (lowestBit >> 32) != 0;
+    const SimdWords half = (lowestBit | (lowestBit >> 32)) & 0xFFFFFFFFLL;
+
+    SimdDoubles asDouble;
+    const SimdWords shifted = half | 0x4330000000000000LL; // the bits of 2^52 + half
+    memcpy(&asDouble, &shifted, sizeof(asDouble));
+    asDouble -= 0x1p52;
+
+    SimdWords bits;
+    memcpy(&bits, &asDouble, sizeof(bits));
+    return (((bits >> 52) - 1023) & 63) + (inHighHalf & 32);
+}
+
+// quotient = numerator / divisor and remainder = numerator % divisor, for 0 <= numerator, divisor <= SIMD_MAX_N.
+// The first estimate of the quotient is off by about numerator * 2^-51 at most, so the remainder
+// of that estimate is small enough for a second estimate to be off by one at most, which two compares fix.
+inline void divideLanes(SimdWords numerator, SimdWords divisor, SimdWords& quotient, SimdWords& remainder) {
+    const SimdDoubles inverse = 1.0 / __builtin_convertvector(divisor, SimdDoubles);
+
+    quotient = __builtin_convertvector(__builtin_convertvector(numerator, SimdDoubles) * inverse, SimdWords);
+    remainder = numerator - multiplyLanes(quotient, divisor);
+
+    quotient += __builtin_convertvector(__builtin_convertvector(remainder, SimdDoubles) * inverse, SimdWords);
+    remainder = numerator - multiplyLanes(quotient, divisor);
+
+    const SimdWords one = broadcastLanes(1);
+    quotient = (remainder < 0) ? quotient - one : quotient;
+    remainder = (remainder < 0) ? remainder + divisor : remainder;
+    quotient = (remainder >= divisor) ? quotient + one : quotient;
+    remainder = (remainder >= divisor) ? remainder - divisor : remainder;
+}
+
+// Stein's binary gcd in every lane, for 0 <= a and 0 < b; the loop runs until the slowest lane is done.
+inline SimdWords gcdLanes(SimdWords a, SimdWords b) {
+    SimdWords x = (a == 0) ? b : a; // gcd(0, b) = b = gcd(b, b)
+    SimdWords y = b;
+    const SimdWords shift = trailingZerosLanes(x | y);
+    x >>= trailingZerosLanes(x);
+
+    // x stays odd and the lanes where y got to 0 are done
+    SimdWords active = (y != 0);
+    while (anyLane(active)) {
+        y >>= trailingZerosLanes(y);
+
+        const SimdWords smaller = (x < y) ? x : y;
+        const SimdWords larger = (x < y) ? y : x;
+        x = active ? smaller : x;
+        y = active ? larger - smaller : y;
+        active = (y != 0);
+    }
+
+    return x << shift;
+}
+
+// Same as sumMaskBlockLcmTable. The entries below the lowest SIMD_LANES are filled by it,
+// and every other highest bit is filled SIMD_LANES parents at a time.
+inline long long sumMaskBlockSimd(const SubsetProblem<long long>& problem, long long blockStart, int tableBits, std::vector<long long>& table) {
+    int prefixCount;
+    long long prefix;
+    if (!lcmOfMaskBits(problem, blockStart, tableBits, prefix, prefixCount)) {
+        return 0; // the bits shared by the whole block are already too big
+    }
+
+    const int scalarBits = std::min(tableBits, __builtin_ctz(SIMD_LANES));
+    long long sum = sumMaskBlockLcmTable(problem, blockStart, scalarBits, table);
+
+    // the operands of a lane select are whole vectors, which GCC compiles to masked moves or blends
+    const SimdWords limit = broadcastLanes(problem.N);
+    const SimdWords zero = broadcastLanes(0);
+    const SimdWords one = broadcastLanes(1);
+    SimdWords laneParity; // the parity of the lane index
+    for (int i = 0; i < SIMD_LANES; ++i) {
+        laneParity[i] = __builtin_parity(i);
+    }
+    const int elementParity = (prefixCount + 1) & 1;
+    SimdUnsignedWords sumLanes = {};
+
+    for (int highestBit = scalarBits; highestBit < tableBits; ++highestBit) {
+        const SimdWords divisor = broadcastLanes(problem.divisors[highestBit]);
+        const int highestMask = 1 << highestBit;
+
+        for (int parentMask = 0; parentMask < highestMask; parentMask += SIMD_LANES) {
+            SimdWords parent;
+            memcpy(&parent, &table[parentMask], sizeof(parent));
+
+            SimdWords unused, parentRemainder, reduced;
+            divideLanes(parent, divisor, unused, parentRemainder);
+            divideLanes(divisor, gcdLanes(parentRemainder, divisor), reduced, unused);
+            const SimdWords product = multiplyLanes(parent, reduced);
+
+            // a parent of 0 (over N) gives a product of 0, so 0 is left exactly in the lanes which are over N
+            const SimdDoubles estimate = __builtin_convertvector(parent, SimdDoubles) * __builtin_convertvector(reduced, SimdDoubles);
+            SimdWords commonMultiple = (product <= limit) ? product : zero;
+            commonMultiple = (estimate <= 0x1p62) ? commonMultiple : zero;
+            memcpy(&table[highestMask | parentMask], &commonMultiple, sizeof(commonMultiple));
+
+            // T(N / L) exactly like addSubsetTerm, dividing by 1 in the lanes of 0; their term stays 0
+            SimdWords cardinality;
+            divideLanes(limit, (commonMultiple != 0) ? commonMultiple : one, cardinality, unused);
+            const SimdWords triangular = multiplyLanes(cardinality, cardinality + one) / 2;
+            const SimdWords term = multiplyLanes(commonMultiple, triangular);
+
+            const SimdWords odd = laneParity ^ (elementParity ^ __builtin_parity(parentMask));
+            sumLanes += (SimdUnsignedWords)((odd != 0) ? term : -term);
+        }
+    }
+
+    unsigned long long laneTotal = 0;
+    for (int i = 0; i < SIMD_LANES; ++i) {
+        laneTotal += sumLanes[i];
+    }
+    return sum + (long long)laneTotal;
+}
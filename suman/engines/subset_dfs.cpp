@@ -0,0 +1,76 @@
+#ifndef subset_dfs_cpp
+#define subset_dfs_cpp
+
+#include <vector>
+
+#include "subset_problem.cpp"
+
+// Pruned depth-first enumeration of the subsets of divisors.
+//
+// Instead of visiting every mask and rebuilding its lcm from scratch, the recursion carries
+// the lcm of the current prefix and extends it by one divisor at a time. As soon as the lcm
+// goes over N, the whole subtree (every superset of that prefix) is cut, since adding
+// divisors can only make the lcm bigger.
+//
+// The chunk protocol of the backends is kept: a mask range [rangeStart, rangeEnd) is split
+// into aligned blocks of 2^lowBits masks which share all the bits above lowBits. The lcm of
+// those shared bits is computed once per block and the DFS only runs over the low bits.
+
+
+// lcmAtDepth[depth] holds the lcm of the current subset; the DFS writes the lcm of the
+// extended subset into lcmAtDepth[depth + 1] so no numbers are allocated while recursing.
+// Sum is usually Number, but it can be anything with an addSubsetTerm overload (see residue_runner.cpp).
+template<typename Number, typename Sum>
+void sumSubsetsDFS(const SubsetProblem<Number>& problem,
+                   int firstBit,
+                   int endBit,
+                   int depth,
+                   int elementCount,
+                   std::vector<Number>& lcmAtDepth,
+                   Sum& sum) {
+    for (int b = firstBit; b < endBit; ++b) {
+        Number& commonMultiple = lcmAtDepth[depth + 1];
+        if (!lcmWithinLimit(lcmAtDepth[depth], problem.divisors[b], problem.N, commonMultiple)) {
+            continue; // every subset containing the current one and b is too big as well
+        }
+
+        addSubsetTerm(sum, problem.N, commonMultiple, elementCount + 1);
+        sumSubsetsDFS(problem, b + 1, endBit, depth + 1, elementCount + 1, lcmAtDepth, sum);
+    }
+}
+
+// Adds the terms of the masks in [blockStart, blockStart + 2^lowBits). blockStart must be a multiple of 2^lowBits.
+template<typename Number, typename Sum>
+void sumMaskBlockDFS(const SubsetProblem<Number>& problem,
+                     long long blockStart,
+                     int lowBits,
+                     std::vector<Number>& lcmAtDepth,
+                     Sum& sum) {
+    int elementCount;
+    if (!lcmOfMaskBits(problem, blockStart, lowBits, lcmAtDepth[0], elementCount)) {
+        return; // the bits shared by the whole block are already too big
+    }
+
+    if (elementCount > 0) { // the empty subset (mask 0) doesn't count
+        addSubsetTerm(sum, problem.N, lcmAtDepth[0], elementCount);
+    }
+
+    sumSubsetsDFS(problem, 0, lowBits, 0, elementCount, lcmAtDepth, sum);
+}
+
+// Returns the same value as iterating over every mask in [rangeStart, rangeEnd).
+template<typename Number>
+Number sumForMaskRangeDFS(const SubsetProblem<Number>& problem, long long rangeStart, long long rangeEnd) {
+    const int numDivisors = problem.numDivisors();
+    std::vector<Number> lcmAtDepth(numDivisors + 1);
+    Number sum = 0;
+
+    forEachAlignedBlock(rangeStart, rangeEnd, numDivisors, [&](long long blockStart, int lowBits) {
+        sumMaskBlockDFS(problem, blockStart, lowBits, lcmAtDepth, sum);
+    });
+
+    return sum;
+}
+
+
+#endif // subset_dfs_cpp
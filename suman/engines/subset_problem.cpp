@@ -0,0 +1,197 @@
+#ifndef subset_problem_cpp
+#define subset_problem_cpp
+
+#include <vector>
+
+#include <gmpxx.h>
+
+#include "quotient_buckets.cpp"
+
+// The inclusion-exclusion problem as seen by the subset engines:
+// the sum of the numbers in [1, N] which are divisible by at least one of the divisors.
+//
+// The engines are templated on the number type and only touch numbers through the
+// overloads below, so that the same enumeration code works for long long and mpz_class.
+template<typename Number>
+struct SubsetProblem {
+    Number N;
+    std::vector<Number> divisors;
+
+    int numDivisors() const {
+        return (int)divisors.size();
+    }
+};
+
+
+inline long long greatestCommonDivisor(long long a, long long b) {
+    while (b != 0) {
+        long long r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+inline mpz_class greatestCommonDivisor(const mpz_class& a, const mpz_class& b) {
+    mpz_class result;
+    mpz_gcd(result.get_mpz_t(), a.get_mpz_t(), b.get_mpz_t());
+    return result;
+}
+
+// result = lcm(a, b). Returns false (and leaves result unspecified) if the lcm is bigger than limit.
+// result may be the same object as a.
+inline bool lcmWithinLimit(long long a, long long b, long long limit, long long& result) {
+    long long reduced = a / greatestCommonDivisor(a, b);
+    if (reduced > limit / b) { // reduced * b > limit, checked without overflowing
+        return false;
+    }
+
+    result = reduced * b;
+    return true;
+}
+
+inline bool lcmWithinLimit(const mpz_class& a, const mpz_class& b, const mpz_class& limit, mpz_class& result) {
+    mpz_lcm(result.get_mpz_t(), a.get_mpz_t(), b.get_mpz_t());
+    return result <= limit;
+}
+
+// result = a * b. Returns false (and leaves result unspecified) if the product is bigger than limit.
+// result may be the same object as a.
+inline bool multiplyWithinLimit(long long a, long long b, long long limit, long long& result) {
+    long long product;
+    if (__builtin_mul_overflow(a, b, &product) || product > limit) {
+        return false;
+    }
+
+    result = product;
+    return true;
+}
+
+inline bool multiplyWithinLimit(const mpz_class& a, const mpz_class& b, const mpz_class& limit, mpz_class& result) {
+    mpz_mul(result.get_mpz_t(), a.get_mpz_t(), b.get_mpz_t());
+    return result <= limit;
+}
+
+// Scratch registers for the mpz_class overloads below, one set per thread. They keep their limbs
+// between calls, so once they have grown to the size of the numbers, evaluating a subset doesn't allocate.
+struct MpzScratch {
+    mpz_class cardinality;
+    mpz_class triangular;
+};
+
+// The set used by the calling thread. It can be pointed to another set for a while,
+// e.g. one whose limbs live in a chunk arena (see chunk_arena.cpp).
+inline MpzScratch*& threadScratchSlot() {
+    static thread_local MpzScratch scratch;
+    static thread_local MpzScratch *current = &scratch;
+    return current;
+}
+
+inline MpzScratch& threadScratch() {
+    return *threadScratchSlot();
+}
+
+// Returns T(N / commonMultiple) = q * (q + 1) / 2, in a scratch register of the calling thread.
+inline mpz_ptr triangularOfQuotient(const mpz_class& N, const mpz_class& commonMultiple) {
+    MpzScratch& scratch = threadScratch();
+    mpz_ptr cardinality = scratch.cardinality.get_mpz_t();
+    mpz_ptr triangular = scratch.triangular.get_mpz_t();
+
+    mpz_tdiv_q(cardinality, N.get_mpz_t(), commonMultiple.get_mpz_t());
+    mpz_add_ui(triangular, cardinality, 1);
+    mpz_mul(triangular, triangular, cardinality);
+    mpz_divexact_ui(triangular, triangular, 2);
+    return triangular;
+}
+
+// Adds (or subtracts, for subsets of even size) the sum of the multiples of commonMultiple in [1, N].
+inline void addSubsetTerm(long long& sum, long long N, long long commonMultiple, int elementCount) {
+    long long subsetCardinality = N / commonMultiple;
+    long long currSubsetSum = commonMultiple * (subsetCardinality * (subsetCardinality + 1) / 2);
+
+    if (elementCount & 1) { // odd
+        sum += currSubsetSum;
+    }
+    else { // even
+        sum -= currSubsetSum;
+    }
+}
+
+// With quotient buckets (see quotient_buckets.cpp) the term goes into the bucket of N / commonMultiple instead of sum.
+inline void addSubsetTerm(mpz_class& sum, const mpz_class& N, const mpz_class& commonMultiple, int elementCount) {
+    QuotientBuckets *buckets = threadBucketsSlot();
+    if (buckets != NULL && buckets->add(N, commonMultiple, (elementCount & 1) ? 1 : -1)) {
+        return;
+    }
+
+    mpz_ptr triangular = triangularOfQuotient(N, commonMultiple);
+
+    if (elementCount & 1) { // odd
+        mpz_addmul(sum.get_mpz_t(), commonMultiple.get_mpz_t(), triangular);
+    }
+    else { // even
+        mpz_submul(sum.get_mpz_t(), commonMultiple.get_mpz_t(), triangular);
+    }
+}
+
+// Same as addSubsetTerm, for a sum of subsets which share commonMultiple, with
+// coefficient = (number of odd subsets) - (number of even subsets).
+inline void addSubsetTermTimes(long long& sum, long long N, long long commonMultiple, long long coefficient) {
+    long long subsetCardinality = N / commonMultiple;
+    long long currSubsetSum = commonMultiple * (subsetCardinality * (subsetCardinality + 1) / 2);
+    sum += coefficient * currSubsetSum;
+}
+
+inline void addSubsetTermTimes(mpz_class& sum, const mpz_class& N, const mpz_class& commonMultiple, long long coefficient) {
+    QuotientBuckets *buckets = threadBucketsSlot();
+    if (buckets != NULL && buckets->add(N, commonMultiple, coefficient)) {
+        return;
+    }
+
+    mpz_ptr triangular = triangularOfQuotient(N, commonMultiple);
+    mpz_mul_si(triangular, triangular, (long)coefficient);
+    mpz_addmul(sum.get_mpz_t(), commonMultiple.get_mpz_t(), triangular);
+}
+
+
+// commonMultiple = lcm of the divisors selected by the bits of mask, starting from firstBit.
+// Returns false if that lcm is bigger than N.
+template<typename Number>
+bool lcmOfMaskBits(const SubsetProblem<Number>& problem, long long mask, int firstBit, Number& commonMultiple, int& elementCount) {
+    elementCount = 0;
+    commonMultiple = 1;
+
+    for (int b = firstBit; b < problem.numDivisors(); ++b) {
+        if (mask & (1LL << b)) {
+            elementCount += 1;
+            if (!lcmWithinLimit(commonMultiple, problem.divisors[b], problem.N, commonMultiple)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Splits [rangeStart, rangeEnd) into blocks of 2^lowBits masks, each starting at a multiple of 2^lowBits,
+// and calls sumBlock(blockStart, lowBits) for each of them. The masks in a block share every bit above lowBits,
+// which is what lets the engines do the work for those bits once per block.
+template<typename BlockFunction>
+void forEachAlignedBlock(long long rangeStart, long long rangeEnd, int numDivisors, BlockFunction sumBlock) {
+    long long blockStart = rangeStart;
+    while (blockStart < rangeEnd) {
+        // take the biggest aligned block which starts at blockStart and fits in the range
+        int lowBits = 0;
+        while (lowBits < numDivisors
+               && (blockStart & ((1LL << (lowBits + 1)) - 1)) == 0
+               && blockStart + (1LL << (lowBits + 1)) <= rangeEnd) {
+            lowBits += 1;
+        }
+
+        sumBlock(blockStart, lowBits);
+        blockStart += (1LL << lowBits);
+    }
+}
+
+
+#endif // subset_problem_cpp
@@ -0,0 +1,315 @@
+#ifndef tiered_cpp
+#define tiered_cpp
+
+#include <vector>
+
+#include <gmpxx.h>
+
+#include "subset_problem.cpp"
+#include "subset_dfs.cpp"
+
+// Tiered-precision DFS for GMP numbers: exact (GMP-correct) results, computed with
+// machine words whenever the numbers allow it.
+//
+// The lcms and the divisions run in 64-bit registers while their operands fit and move to
+// unsigned __int128 when they don't. Each subset term L * T(N / L) is computed with checked
+// 128-bit multiplications, and only a term which overflows is recomputed with mpz_class.
+// The terms are summed in a signed __int128 accumulator which is flushed into an mpz_class
+// only when the addition would overflow.
+//
+// For every N below 2^63 each term fits in 126 bits, so GMP is only touched for the few big terms
+// of a bigger N. When N doesn't fit in 128 bits at all, the whole range runs on mpz_class.
+
+static_assert(GMP_LIMB_BITS == 64, "the tiered kernel converts between __int128 and mpz limbs");
+
+typedef unsigned __int128 uint128;
+typedef __int128 int128;
+
+const uint128 INT128_MAXIMUM = ~(uint128)0 >> 1;
+
+inline bool fitsUint128(const mpz_class& x) {
+    return sgn(x) >= 0 && mpz_sizeinbase(x.get_mpz_t(), 2) <= 128;
+}
+
+// x must fit in 128 bits
+inline uint128 toUint128(const mpz_class& x) {
+    const mpz_srcptr number = x.get_mpz_t();
+    uint128 low = (mpz_size(number) > 0) ? mpz_getlimbn(number, 0) : 0;
+    uint128 high = (mpz_size(number) > 1) ? mpz_getlimbn(number, 1) : 0;
+    return (high << 64) | low;
+}
+
+inline void setFromUint128(mpz_class& x, uint128 value) {
+    const mpz_ptr number = x.get_mpz_t();
+    mpz_set_ui(number, (unsigned long)(value >> 64));
+    mpz_mul_2exp(number, number, 64);
+    mpz_add_ui(number, number, (unsigned long)value);
+}
+
+inline void addInt128(mpz_class& x, int128 value, mpz_class& scratch) {
+    if (value >= 0) {
+        setFromUint128(scratch, (uint128)value);
+        x += scratch;
+    }
+    else {
+        setFromUint128(scratch, -(uint128)value);
+        x -= scratch;
+    }
+}
+
+inline bool fitsUint64(uint128 x) {
+    return (x >> 64) == 0;
+}
+
+inline uint128 binaryGcd(uint128 a, uint128 b) {
+    if (fitsUint64(a) && fitsUint64(b)) { // the common case, in 64-bit registers
+        unsigned long long x = (unsigned long long)a, y = (unsigned long long)b;
+        if (x == 0 || y == 0) {
+            return x | y;
+        }
+
+        const int shift = __builtin_ctzll(x | y);
+        x >>= __builtin_ctzll(x);
+        while (y != 0) {
+            y >>= __builtin_ctzll(y);
+            if (x > y) {
+                unsigned long long t = x;
+                x = y;
+                y = t;
+            }
+            y -= x;
+        }
+        return (uint128)(x << shift);
+    }
+
+    if (a == 0 || b == 0) {
+        return a | b;
+    }
+
+    // usually only the lcm is wide; one remainder brings both operands down to 64 bits
+    if (fitsUint64(b)) {
+        return binaryGcd(b, a % (unsigned long long)b);
+    }
+    if (fitsUint64(a)) {
+        return binaryGcd(a, b % (unsigned long long)a);
+    }
+
+    auto ctz128 = [](uint128 x) {
+        unsigned long long low = (unsigned long long)x;
+        return (low != 0) ? __builtin_ctzll(low) : 64 + __builtin_ctzll((unsigned long long)(x >> 64));
+    };
+
+    const int shift = ctz128(a | b);
+    a >>= ctz128(a);
+    while (b != 0) {
+        b >>= ctz128(b);
+        if (a > b) {
+            uint128 t = a;
+            a = b;
+            b = t;
+        }
+        b -= a;
+    }
+    return a << shift;
+}
+
+inline uint128 divide128(uint128 a, uint128 b) {
+    if (fitsUint64(a) && fitsUint64(b)) {
+        return (unsigned long long)a / (unsigned long long)b;
+    }
+    return a / b;
+}
+
+
+// The problem converted to words once. Only usable when N fits in 128 bits, and then every lcm
+// which isn't bigger than N fits as well; a divisor which doesn't fit is simply too big.
+struct TieredProblem {
+    bool nFits;
+    uint128 N;
+    std::vector<char> divisorFits;
+    std::vector<uint128> divisors;
+};
+
+inline TieredProblem buildTieredProblem(const SubsetProblem<mpz_class>& problem) {
+    TieredProblem tiered;
+    tiered.nFits = fitsUint128(problem.N);
+    tiered.N = tiered.nFits ? toUint128(problem.N) : 0;
+
+    for (const mpz_class& d : problem.divisors) {
+        tiered.divisorFits.push_back(fitsUint128(d));
+        tiered.divisors.push_back(fitsUint128(d) ? toUint128(d) : 0);
+    }
+    return tiered;
+}
+
+// result = lcm(a, divisors[b]). Returns false if it's bigger than N. result may be the same object as a.
+inline bool lcmWithinLimit(const TieredProblem& tiered, uint128 a, int b, uint128& result) {
+    if (!tiered.divisorFits[b]) {
+        return false;
+    }
+
+    const uint128 divisor = tiered.divisors[b];
+    const uint128 reduced = divide128(a, binaryGcd(a, divisor));
+    uint128 product;
+    if (__builtin_mul_overflow(reduced, divisor, &product) || product > tiered.N) {
+        return false;
+    }
+
+    result = product;
+    return true;
+}
+
+class TieredAccumulator {
+public:
+    TieredAccumulator(): partial(0) {
+    }
+
+    // Adds (or subtracts, for subsets of even size) the sum of the multiples of commonMultiple in [1, N].
+    void addSubsetTerm(const SubsetProblem<mpz_class>& problem,
+                       const TieredProblem& tiered,
+                       uint128 commonMultiple,
+                       int elementCount) {
+        const uint128 subsetCardinality = divide128(tiered.N, commonMultiple);
+        if (addWordTerm(subsetCardinality, commonMultiple, elementCount)) {
+            return;
+        }
+
+        // the term doesn't fit in 127 bits
+        setFromUint128(scratchLcm, commonMultiple);
+        setFromUint128(scratchCardinality, subsetCardinality);
+        mpz_add_ui(scratchTerm.get_mpz_t(), scratchCardinality.get_mpz_t(), 1);
+        scratchTerm *= scratchCardinality;
+        mpz_tdiv_q_2exp(scratchTerm.get_mpz_t(), scratchTerm.get_mpz_t(), 1);
+
+        if (elementCount & 1) { // odd
+            mpz_addmul(sum.get_mpz_t(), scratchLcm.get_mpz_t(), scratchTerm.get_mpz_t());
+        }
+        else { // even
+            mpz_submul(sum.get_mpz_t(), scratchLcm.get_mpz_t(), scratchTerm.get_mpz_t());
+        }
+    }
+
+    mpz_class total() {
+        mpz_class result = sum;
+        addInt128(result, partial, scratchTerm);
+        return result;
+    }
+
+private:
+    int128 partial; // flushed into sum before it overflows
+    mpz_class sum;
+    mpz_class scratchLcm, scratchCardinality, scratchTerm;
+
+    // false if the term doesn't fit in 127 bits
+    bool addWordTerm(uint128 subsetCardinality, uint128 commonMultiple, int elementCount) {
+        uint128 a = subsetCardinality, b = subsetCardinality + 1;
+        if (b == 0) {
+            return false;
+        }
+        if (a % 2 == 0) {
+            a /= 2;
+        }
+        else {
+            b /= 2;
+        }
+
+        uint128 triangular, term;
+        if (__builtin_mul_overflow(a, b, &triangular)
+            || __builtin_mul_overflow(triangular, commonMultiple, &term)
+            || term > INT128_MAXIMUM) {
+            return false;
+        }
+
+        int128 signedTerm = (elementCount & 1) ? (int128)term : -(int128)term;
+        int128 next;
+        if (__builtin_add_overflow(partial, signedTerm, &next)) {
+            addInt128(sum, partial, scratchTerm);
+            next = signedTerm;
+        }
+        partial = next;
+        return true;
+    }
+};
+
+// Accumulator is anything with the addSubsetTerm of TieredAccumulator (see also residue_runner.cpp).
+template<typename Accumulator>
+void sumSubsetsTieredDFS(const SubsetProblem<mpz_class>& problem,
+                         const TieredProblem& tiered,
+                         int firstBit,
+                         int endBit,
+                         int depth,
+                         int elementCount,
+                         std::vector<uint128>& lcmAtDepth,
+                         Accumulator& sum) {
+    for (int b = firstBit; b < endBit; ++b) {
+        uint128& commonMultiple = lcmAtDepth[depth + 1];
+        if (!lcmWithinLimit(tiered, lcmAtDepth[depth], b, commonMultiple)) {
+            continue; // every subset containing the current one and b is too big as well
+        }
+
+        sum.addSubsetTerm(problem, tiered, commonMultiple, elementCount + 1);
+        sumSubsetsTieredDFS(problem, tiered, b + 1, endBit, depth + 1, elementCount + 1, lcmAtDepth, sum);
+    }
+}
+
+// Adds the terms of every mask in [rangeStart, rangeEnd) to sum. Only for tiered.nFits.
+template<typename Accumulator>
+void sumMaskRangeTieredInto(const SubsetProblem<mpz_class>& problem,
+                            const TieredProblem& tiered,
+                            long long rangeStart,
+                            long long rangeEnd,
+                            Accumulator& sum) {
+    const int numDivisors = problem.numDivisors();
+    std::vector<uint128> lcmAtDepth(numDivisors + 1);
+
+    forEachAlignedBlock(rangeStart, rangeEnd, numDivisors, [&](long long blockStart, int lowBits) {
+        // the bits shared by the whole block
+        lcmAtDepth[0] = 1;
+        int elementCount = 0;
+        for (int b = lowBits; b < numDivisors; ++b) {
+            if (blockStart & (1LL << b)) {
+                elementCount += 1;
+                if (!lcmWithinLimit(tiered, lcmAtDepth[0], b, lcmAtDepth[0])) {
+                    return;
+                }
+            }
+        }
+
+        if (elementCount > 0) { // the empty subset (mask 0) doesn't count
+            sum.addSubsetTerm(problem, tiered, lcmAtDepth[0], elementCount);
+        }
+
+        sumSubsetsTieredDFS(problem, tiered, 0, lowBits, 0, elementCount, lcmAtDepth, sum);
+    });
+}
+
+// Returns the same value as iterating over every mask in [rangeStart, rangeEnd).
+inline mpz_class sumForMaskRangeTiered(const SubsetProblem<mpz_class>& problem,
+                                       const TieredProblem& tiered,
+                                       long long rangeStart,
+                                       long long rangeEnd) {
+    if (!tiered.nFits) {
+        // the lcms themselves may need GMP, so the whole range goes to the mpz_class DFS
+        return sumForMaskRangeDFS(problem, rangeStart, rangeEnd);
+    }
+
+    TieredAccumulator sum;
+    sumMaskRangeTieredInto(problem, tiered, rangeStart, rangeEnd, sum);
+    return sum.total();
+}
+
+// 64-bit numbers can't hold an answer which doesn't fit in a long long anyway,
+// so for them the tiered kernel is the plain DFS.
+inline TieredProblem buildTieredProblem(const SubsetProblem<long long>& problem) {
+    return TieredProblem();
+}
+
+inline long long sumForMaskRangeTiered(const SubsetProblem<long long>& problem,
+                                       const TieredProblem& tiered,
+                                       long long rangeStart,
+                                       long long rangeEnd) {
+    return sumForMaskRangeDFS(problem, rangeStart, rangeEnd);
+}
+
+
+#endif // tiered_cpp
@@ -0,0 +1,155 @@
+#ifndef wide_cpp
+#define wide_cpp
+
+#include <gmpxx.h>
+
+#include "../data_structures/wide_int.cpp"
+#include "subset_problem.cpp"
+#include "subset_dfs.cpp"
+
+// The DFS engine on fixed-width integers, for bigNumber inputs whose numbers fit in a few limbs.
+//
+// The width is picked at run time from a bound on the biggest value a range can produce: every
+// lcm which is kept is at most N, so every product tried along the way has fewer than 2 * bits(N)
+// bits, each term L * T(N / L) is at most N * (N + 1) / 2, and the partial sum of a range is at most
+// 2^K such terms in absolute value. The sum is accumulated modulo 2^(64 * Limbs) and read back in
+// two's complement, so it only has to fit (with its sign) at the end.
+
+static_assert(GMP_LIMB_BITS == 64, "the wide kernel converts between wide_uint and mpz limbs");
+
+const int WIDE_LIMB_COUNTS[] = {2, 3, 4, 6, 8};
+
+
+template<int Limbs>
+bool lcmWithinLimit(const wide_uint<Limbs>& a, const wide_uint<Limbs>& b, const wide_uint<Limbs>& limit, wide_uint<Limbs>& result) {
+    wide_uint<Limbs> product;
+    if (b.fits_limb()) {
+        // the usual case, a small divisor: lcm(a, b) = a * (b / gcd(a mod b, b)), with a single division of a
+        wide_uint<Limbs> quotient = a;
+        const unsigned long long g = wide_uint<Limbs>::gcd_of_limbs(b.limbs[0], quotient.divide_by_limb(b.limbs[0]));
+        if (wide_uint<Limbs>::multiply_overflows(a, wide_uint<Limbs>(b.limbs[0] / g), product) || limit < product) {
+            return false;
+        }
+    }
+    else {
+        wide_uint<Limbs> reduced;
+        wide_uint<Limbs>::divide(a, gcd(a, b), reduced);
+        if (wide_uint<Limbs>::multiply_overflows(reduced, b, product) || limit < product) {
+            return false;
+        }
+    }
+
+    result = product;
+    return true;
+}
+
+template<int Limbs>
+void addSubsetTerm(wide_uint<Limbs>& sum, const wide_uint<Limbs>& N, const wide_uint<Limbs>& commonMultiple, int elementCount) {
+    wide_uint<Limbs> subsetCardinality, next;
+    wide_uint<Limbs>::divide(N, commonMultiple, subsetCardinality);
+    next = subsetCardinality;
+    next += 1;
+
+    // T(q) = q * (q + 1) / 2, halving whichever of the two is even
+    if ((subsetCardinality.limbs[0] & 1) == 0) {
+        subsetCardinality >>= 1;
+    }
+    else {
+        next >>= 1;
+    }
+
+    wide_uint<Limbs> currSubsetSum = subsetCardinality;
+    currSubsetSum *= next;
+    currSubsetSum *= commonMultiple;
+
+    if (elementCount & 1) { // odd
+        sum += currSubsetSum;
+    }
+    else { // even
+        sum -= currSubsetSum;
+    }
+}
+
+
+template<int Limbs>
+wide_uint<Limbs> toWide(const mpz_class& x) {
+    const mpz_srcptr number = x.get_mpz_t();
+    wide_uint<Limbs> result;
+    for (int i = 0; i < Limbs && i < (int)mpz_size(number); ++i) {
+        result.limbs[i] = mpz_getlimbn(number, i);
+    }
+    return result;
+}
+
+template<int Limbs>
+mpz_class toMpz(const wide_int<Limbs>& x) {
+    const wide_uint<Limbs> magnitude = x.magnitude();
+
+    mpz_class result;
+    mpz_import(result.get_mpz_t(), Limbs, -1, sizeof(magnitude.limbs[0]), 0, 0, magnitude.limbs);
+    if (x.is_negative()) {
+        result = -result;
+    }
+    return result;
+}
+
+// The fewest limbs for which nothing can overflow while summing a range (see above),
+// or 0 if more than the widest wide_uint would be needed.
+inline int wideLimbsFor(const SubsetProblem<mpz_class>& problem) {
+    const long long bitsNeeded = 2 * (long long)mpz_sizeinbase(problem.N.get_mpz_t(), 2) + problem.numDivisors() + 2;
+    for (int limbs : WIDE_LIMB_COUNTS) {
+        if (64 * limbs >= bitsNeeded) {
+            return limbs;
+        }
+    }
+    return 0;
+}
+
+template<int Limbs>
+mpz_class sumForMaskRangeWideLimbs(const SubsetProblem<mpz_class>& problem, long long rangeStart, long long rangeEnd) {
+    SubsetProblem<wide_uint<Limbs>> wideProblem;
+    wideProblem.N = toWide<Limbs>(problem.N);
+    for (const mpz_class& d : problem.divisors) {
+        if (d <= problem.N) {
+            wideProblem.divisors.push_back(toWide<Limbs>(d));
+        }
+        else { // might not fit, but any value bigger than N does the same
+            wideProblem.divisors.push_back(wideProblem.N);
+            wideProblem.divisors.back() += 1;
+        }
+    }
+
+    wide_uint<Limbs> sum = sumForMaskRangeDFS(wideProblem, rangeStart, rangeEnd);
+    return toMpz(wide_int<Limbs>(sum));
+}
+
+// Returns the same value as iterating over every mask in [rangeStart, rangeEnd).
+// limbs is what wideLimbsFor returned; for 0 the mpz_class DFS is used.
+inline mpz_class sumForMaskRangeWide(const SubsetProblem<mpz_class>& problem, int limbs, long long rangeStart, long long rangeEnd) {
+    switch (limbs) {
+        case 2:
+            return sumForMaskRangeWideLimbs<2>(problem, rangeStart, rangeEnd);
+        case 3:
+            return sumForMaskRangeWideLimbs<3>(problem, rangeStart, rangeEnd);
+        case 4:
+            return sumForMaskRangeWideLimbs<4>(problem, rangeStart, rangeEnd);
+        case 6:
+            return sumForMaskRangeWideLimbs<6>(problem, rangeStart, rangeEnd);
+        case 8:
+            return sumForMaskRangeWideLimbs<8>(problem, rangeStart, rangeEnd);
+        default:
+            return sumForMaskRangeDFS(problem, rangeStart, rangeEnd);
+    }
+}
+
+// 64-bit numbers already are machine words.
+inline int wideLimbsFor(const SubsetProblem<long long>& problem) {
+    return 0;
+}
+
+inline long long sumForMaskRangeWide(const SubsetProblem<long long>& problem, int limbs, long long rangeStart, long long rangeEnd) {
+    return sumForMaskRangeDFS(problem, rangeStart, rangeEnd);
+}
+
+
+#endif // wide_cpp
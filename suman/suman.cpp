@@ -0,0 +1,498 @@
+#include <chrono>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+
+#include <gmpxx.h>
+#include <mpi.h>
+#include "backends/sequential.cpp"
+#include "backends/threads.cpp"
+#include "backends/mpi_static.cpp"
+#include "backends/mpi_dynamic.cpp"
+#include "engines/planner.cpp"
+#include "engines/bonferroni.cpp"
+
+using namespace std;
+
+
+enum Backend {
+    BACKEND_SEQUENTIAL,   // "sequential"
+    BACKEND_THREADS,      // "threads": lock-free work list shared by --threads threads
+    BACKEND_MPI_STATIC,   // "mpi-static": equal shares, partial sums reduced on the master
+    BACKEND_MPI_DYNAMIC,  // "mpi-dynamic": the master hands out chunks as the slaves finish them
+};
+
+struct DriverOptions {
+    bool bigNumber;
+    bool residues; // "--number crt": bigNumber, summed modulo several primes (see residues.cpp)
+    bool hasModulus; // "--mod P": only the answer modulo P is wanted; implies "--number crt"
+    unsigned long long modulus;
+    bool planned; // "--plan": the number type, kernel and (unless it's an MPI one) backend come from planner.cpp
+    bool bonferroni; // "--bonferroni": the levels of bonferroni.cpp, until the bounds are within tolerance or timeBudget runs out
+    double tolerance; // "--tolerance", relative to the upper bound
+    double timeBudget; // "--time-budget", in seconds; 0 if there's none
+    const char *queriesFile; // "--queries": many N from one table of lcms (see multi_query.cpp); NULL if there's none
+    Backend backend;
+    bool hasKernel; // otherwise defaultMaskKernel of the number type
+    MaskKernel kernel;
+    BackendOptions backendOptions;
+};
+
+void printUsage(const char *program) {
+    printf("Usage: %s [--number long|big|crt] [--backend sequential|threads|mpi-static|mpi-dynamic]"
+           " [--kernel dfs|skip|map|exp|tiered|wide|table|gray|simd|prefix|clique|mitm|sieve|period] [--threads NUMBER_THREADS] [--work-list stack|queue]"
+           " [--arena] [--buckets] [--mod P] [--plan] [--bonferroni [--tolerance EPS] [--time-budget SECONDS]] [--queries FILE] [--debug DEBUG_LEVEL]\n",
+           program);
+}
+
+bool usesMPI(Backend backend) {
+    return backend == BACKEND_MPI_STATIC || backend == BACKEND_MPI_DYNAMIC;
+}
+
+// Returns false if the arguments don't make sense.
+bool parseArguments(int argc, char *argv[], DriverOptions& options) {
+    options.bigNumber = true;
+    options.residues = false;
+    options.hasModulus = false;
+    options.planned = false;
+    options.bonferroni = false;
+    options.tolerance = 0;
+    options.timeBudget = 0;
+    options.queriesFile = NULL;
+    options.backend = BACKEND_SEQUENTIAL;
+    options.hasKernel = false;
+    options.backendOptions = {.debug = 0, .threads = 1, .workList = WORK_LIST_STACK, .gmpArena = false, .quotientBuckets = false};
+
+    for (int i = 1; i < argc; ++i) {
+        const char *flag = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(flag, "--arena") == 0) {
+            options.backendOptions.gmpArena = true;
+            continue;
+        }
+        if (strcmp(flag, "--buckets") == 0) {
+            options.backendOptions.quotientBuckets = true;
+            continue;
+        }
+        if (strcmp(flag, "--plan") == 0) {
+            options.planned = true;
+            continue;
+        }
+        if (strcmp(flag, "--bonferroni") == 0) {
+            options.bonferroni = true;
+            continue;
+        }
+
+        // every other flag takes a value
+        if (value == NULL) {
+            return false;
+        }
+        i += 1;
+
+        if (strcmp(flag, "--number") == 0) {
+            if (strcmp(value, "long") != 0 && strcmp(value, "big") != 0 && strcmp(value, "crt") != 0) {
+                return false;
+            }
+            options.bigNumber = (strcmp(value, "long") != 0);
+            options.residues = (strcmp(value, "crt") == 0);
+        }
+        else if (strcmp(flag, "--backend") == 0) {
+            if (strcmp(value, "sequential") == 0) {
+                options.backend = BACKEND_SEQUENTIAL;
+            }
+            else if (strcmp(value, "threads") == 0) {
+                options.backend = BACKEND_THREADS;
+            }
+            else if (strcmp(value, "mpi-static") == 0) {
+                options.backend = BACKEND_MPI_STATIC;
+            }
+            else if (strcmp(value, "mpi-dynamic") == 0) {
+                options.backend = BACKEND_MPI_DYNAMIC;
+            }
+            else {
+                return false;
+            }
+        }
+        else if (strcmp(flag, "--kernel") == 0) {
+            if (!parseMaskKernel(value, options.kernel)) {
+                return false;
+            }
+            options.hasKernel = true;
+        }
+        else if (strcmp(flag, "--threads") == 0) {
+            options.backendOptions.threads = atoi(value);
+            if (options.backendOptions.threads < 1) {
+                return false;
+            }
+        }
+        else if (strcmp(flag, "--work-list") == 0) {
+            if (strcmp(value, "stack") != 0 && strcmp(value, "queue") != 0) {
+                return false;
+            }
+            options.backendOptions.workList = (strcmp(value, "queue") == 0) ? WORK_LIST_QUEUE : WORK_LIST_STACK;
+        }
+        else if (strcmp(flag, "--mod") == 0) {
+            char *end;
+            options.modulus = strtoull(value, &end, 10);
+            if (*end != '\0' || options.modulus < 1 || options.modulus >= (1ULL << 63)) {
+                return false;
+            }
+            options.hasModulus = true;
+        }
+        else if (strcmp(flag, "--tolerance") == 0 || strcmp(flag, "--time-budget") == 0) {
+            char *end;
+            const double number = strtod(value, &end);
+            if (*end != '\0' || !(number >= 0)) {
+                return false;
+            }
+            if (strcmp(flag, "--tolerance") == 0) {
+                options.tolerance = number;
+            }
+            else {
+                options.timeBudget = number;
+            }
+        }
+        else if (strcmp(flag, "--queries") == 0) {
+            options.queriesFile = value;
+        }
+        else if (strcmp(flag, "--debug") == 0) {
+            options.backendOptions.debug = atoi(value);
+        }
+        else {
+            return false;
+        }
+    }
+
+    if (options.queriesFile != NULL) {
+        if (usesMPI(options.backend) || options.hasModulus || options.planned || options.bonferroni) {
+            return false; // the table is built and evaluated by this process alone
+        }
+        options.residues = false;
+    }
+
+    if (options.bonferroni) {
+        if (options.hasModulus || options.planned) {
+            return false; // the bounds are of the answer itself, and there's nothing to plan
+        }
+        options.bigNumber = true;
+        options.residues = false;
+    }
+    else if (options.tolerance != 0 || options.timeBudget != 0) {
+        return false;
+    }
+
+    if (options.hasModulus || options.planned) {
+        options.bigNumber = true; // the plan reads the input as GMP numbers, and narrows it if it can
+        options.residues = options.hasModulus;
+    }
+
+    // the arena and the buckets only hold GMP numbers
+    return (!options.backendOptions.gmpArena && !options.backendOptions.quotientBuckets) || options.bigNumber;
+}
+
+
+template<typename Runner, typename Number>
+typename Runner::Sum runBackend(const DriverOptions& options, const Runner& runner, const SubsetProblem<Number>& problem) {
+    const BackendOptions& backendOptions = options.backendOptions;
+    switch (options.backend) {
+        case BACKEND_THREADS:
+            return runThreads(runner, problem, backendOptions);
+        case BACKEND_MPI_STATIC:
+            return runMpiStatic(runner, problem, backendOptions);
+        case BACKEND_MPI_DYNAMIC:
+            return runMpiDynamic(runner, problem, backendOptions);
+        case BACKEND_SEQUENTIAL:
+        default:
+            return runSequential(runner, problem, backendOptions);
+    }
+}
+
+template<typename Number>
+Number sumWithKernels(const DriverOptions& options, int rank, const SubsetProblem<Number>& problem) {
+    MaskKernel kernel = options.hasKernel ? options.kernel : defaultMaskKernel<Number>();
+    if (problem.numDivisors() > MASK_MAX_DIVISORS && kernelNeedsMasks(kernel)) {
+        // too many divisors for 64-bit masks
+        kernel = MASK_KERNEL_PREFIX_DFS;
+        if (rank == MASTER_RANK && options.backendOptions.debug >= 1) {
+            cout << "More than " << MASK_MAX_DIVISORS << " divisors, using the prefix kernel" << endl;
+        }
+    }
+    // only the threads backend has threads to spare for the precomputation
+    const int buildThreads = (options.backend == BACKEND_THREADS) ? options.backendOptions.threads : 1;
+    MaskKernelRunner<Number> runner(kernel, problem, buildThreads);
+    return runBackend(options, runner, problem);
+}
+
+// The "--number crt" path. Returns false (and does nothing) if N doesn't fit the residue runner.
+bool sumWithResidues(const DriverOptions& options, int rank, const SubsetProblem<mpz_class>& problem, mpz_class& totalSum) {
+    if (!fitsResidueRunner(problem)) {
+        if (rank == MASTER_RANK && options.backendOptions.debug >= 1) {
+            cout << "N doesn't fit in 128 bits, summing with GMP numbers" << endl;
+        }
+        return false;
+    }
+
+    if (options.hasModulus && options.modulus % 2 == 1) {
+        // the residue modulo P is all that's needed; Montgomery products need an odd modulus
+        installResidueModulus(options.modulus);
+        if (rank == MASTER_RANK && options.backendOptions.debug >= 1) {
+            cout << "Summing modulo " << options.modulus << endl;
+        }
+    }
+    else {
+        installResidueModuli(problem.N * (problem.N + 1) / 2); // the answer is at most T(N)
+        if (rank == MASTER_RANK && options.backendOptions.debug >= 1) {
+            cout << "Summing modulo " << residueModuli().count << " primes" << endl;
+        }
+    }
+
+    ResidueRunner runner(problem);
+    totalSum = reconstructResidues(runBackend(options, runner, problem));
+    return true;
+}
+
+bool sumWithResidues(const DriverOptions& options, int rank, const SubsetProblem<long long>& problem, long long& totalSum) {
+    return false;
+}
+
+// Reads the input (on the master, which broadcasts it for the MPI backends) and sets rank.
+// Returns false on every process if the input is malformed.
+template<typename Number>
+bool loadProblem(const DriverOptions& options, int& rank, SubsetProblem<Number>& problem) {
+    const int debug = options.backendOptions.debug;
+
+    rank = MASTER_RANK;
+    if (usesMPI(options.backend)) {
+        int procNum;
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &procNum);
+        if (debug >= 1) {
+            MPIPrintf("I am rank %i out of %i running on pid %i\n", rank, procNum, (int)getpid());
+        }
+
+        if (!broadcastProblem(rank, debug, problem)) {
+            return false;
+        }
+    }
+    else if (!readProblem(debug, problem)) {
+        return false;
+    }
+
+    if (rank == MASTER_RANK && debug >= 1) {
+        cout << "N = " << problem.N << "; numDivisors = " << problem.numDivisors() << '\n';
+        for (int i = 0; i < problem.numDivisors(); ++i) {
+            cout << "divisors[" << i << "] = " << problem.divisors[i] << '\n';
+        }
+        cout.flush();
+    }
+
+    return true;
+}
+
+template<typename Number>
+Number sumProblem(const DriverOptions& options, int rank, const SubsetProblem<Number>& problem) {
+    if (options.backendOptions.gmpArena) {
+        gmp_bump_allocator::install();
+    }
+
+    Number totalSum;
+    if (!options.residues || !sumWithResidues(options, rank, problem, totalSum)) {
+        totalSum = sumWithKernels(options, rank, problem);
+    }
+    if (options.hasModulus) {
+        totalSum = totalSum % Number((long)options.modulus); // the answer isn't negative
+    }
+    return totalSum;
+}
+
+template<typename Number>
+void printAnswer(int rank, const Number& totalSum) {
+    if (rank == MASTER_RANK) {
+        writeAnswer(totalSum);
+        cout << totalSum << endl;
+    }
+}
+
+// Returns false if the input is malformed, like the other run functions.
+template<typename Number>
+bool runSuman(const DriverOptions& options) {
+    int rank;
+    SubsetProblem<Number> problem;
+    if (!loadProblem(options, rank, problem)) {
+        return false;
+    }
+    printAnswer(rank, sumProblem(options, rank, problem));
+    return true;
+}
+
+// "--plan": the input is read as GMP numbers, probed, and run the way planFor says.
+bool runPlanned(const DriverOptions& options) {
+    int rank;
+    SubsetProblem<mpz_class> problem;
+    if (!loadProblem(options, rank, problem)) {
+        return false;
+    }
+
+    const ProblemProbes probes = probeProblem(problem);
+    const Plan plan = planFor(probes, std::max(1, (int)std::thread::hardware_concurrency()));
+
+    DriverOptions planned = options;
+    planned.hasKernel = true;
+    planned.kernel = plan.kernel;
+    if (!options.hasModulus) { // "--mod" keeps its residues, and only the backend is planned
+        planned.bigNumber = (plan.number != PLAN_NUMBER_LONG);
+        planned.residues = (plan.number == PLAN_NUMBER_CRT);
+    }
+    if (!usesMPI(options.backend)) { // the processes are already running, so an MPI backend stays
+        planned.backend = (plan.threads > 1) ? BACKEND_THREADS : BACKEND_SEQUENTIAL;
+        planned.backendOptions.threads = plan.threads;
+    }
+
+    if (rank == MASTER_RANK && options.backendOptions.debug >= 1) {
+        cout << describeProbes(probes) << '\n' << describePlan(plan) << endl;
+    }
+
+    if (!planned.bigNumber) {
+        SubsetProblem<long long> narrow; // the answer fits, so N and the divisors do too
+        narrow.N = problem.N.get_si();
+        for (const mpz_class& divisor : problem.divisors) {
+            narrow.divisors.push_back(divisor.get_si());
+        }
+        printAnswer(rank, sumProblem(planned, rank, narrow));
+    }
+    else {
+        printAnswer(rank, sumProblem(planned, rank, problem));
+    }
+    return true;
+}
+
+// "--bonferroni": the levels of bonferroni.cpp, one backend run each, while the interval is too wide and a level
+// looks like it fits in what's left of the time budget. The master decides and tells the other processes.
+bool runBonferroni(const DriverOptions& options) {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+
+    int rank;
+    SubsetProblem<mpz_class> problem;
+    if (!loadProblem(options, rank, problem)) {
+        return false;
+    }
+    const BonferroniProblem bonferroni(problem);
+    BonferroniBounds bounds(problem.N);
+
+    double lastLevelSeconds = 0;
+    int goOn = 1;
+    for (int level = 1; goOn; ++level) { // only the master has the bounds
+        const Clock::time_point levelStart = Clock::now();
+        BonferroniLevelRunner runner(bonferroni, level);
+        const mpz_class levelSum = runBackend(options, runner, problem);
+
+        if (rank == MASTER_RANK) {
+            bounds.addLevel(levelSum);
+            cout << "Level " << bounds.levels << ": [" << bounds.lower << ", " << bounds.upper << "]" << endl;
+
+            // the next level should take at least as long, and longer by as much as this one grew
+            const Clock::time_point now = Clock::now();
+            const double levelSeconds = std::chrono::duration<double>(now - levelStart).count();
+            const double growth = (lastLevelSeconds > 0) ? std::max(1.0, levelSeconds / lastLevelSeconds) : 1.0;
+            const double predictedEnd = std::chrono::duration<double>(now - start).count() + levelSeconds * growth;
+            lastLevelSeconds = levelSeconds;
+
+            goOn = !bounds.within(options.tolerance) && (options.timeBudget == 0 || predictedEnd <= options.timeBudget);
+        }
+        if (usesMPI(options.backend)) {
+            MPI_Bcast(&goOn, 1, MPI_INT, MASTER_RANK, MPI_COMM_WORLD);
+        }
+    }
+
+    if (bounds.exact) {
+        if (rank == MASTER_RANK) {
+            cout << "Exact after " << bounds.levels << " levels" << endl;
+        }
+        printAnswer(rank, bounds.partialSum);
+        return true;
+    }
+
+    // not the answer, so OUTPUT_FILE gets the interval and the estimate is only printed, with a label
+    if (rank == MASTER_RANK) {
+        const std::string interval = "[" + numberToString(bounds.lower) + ", " + numberToString(bounds.upper) + "]";
+        cout << "Stopped after " << bounds.levels << " levels; the answer is in " << interval << '\n';
+        cout << "Estimate: " << densityEstimate(problem, bounds) << endl;
+        writeAnswer(interval);
+    }
+    return true;
+}
+
+// "--queries": the answer for every N or interval of the file, one per line. Returns false if the file or the input can't be read.
+template<typename Number>
+bool runQueries(const DriverOptions& options) {
+    const int debug = options.backendOptions.debug;
+
+    std::vector<IntervalQuery<Number>> queries;
+    if (!readQueries(options.queriesFile, queries)) {
+        cout << "Can't read the queries from " << options.queriesFile << endl;
+        return false;
+    }
+
+    const std::vector<Number> points = queryPoints(queries);
+    std::vector<Number> values;
+    if (!points.empty()) {
+        SubsetProblem<Number> problem;
+        if (!readProblem(debug, problem, &points.back())) { // pruned against the biggest N
+            return false;
+        }
+        size_t tableSize;
+        evaluateQueryPoints(problem, points, values, tableSize);
+        if (debug >= 1) {
+            cout << "N = " << problem.N << "; numDivisors = " << problem.numDivisors() << "; "
+                 << tableSize << " lcms in the table, evaluated at " << points.size() << " points" << endl;
+        }
+    }
+
+    const std::vector<Number> answers = answerQueries(queries, points, values);
+    writeAnswers(answers);
+    for (const Number& answer : answers) {
+        cout << answer << '\n';
+    }
+    cout.flush();
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    DriverOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage(argv[0]);
+        return -1;
+    }
+
+    if (usesMPI(options.backend)) {
+        MPI_Init(&argc, &argv);
+    }
+
+    bool succeeded;
+    if (options.planned) {
+        succeeded = runPlanned(options);
+    }
+    else if (options.bonferroni) {
+        succeeded = runBonferroni(options);
+    }
+    else if (options.queriesFile != NULL) {
+        succeeded = options.bigNumber ? runQueries<mpz_class>(options) : runQueries<long long>(options);
+    }
+    else if (options.bigNumber) {
+        succeeded = runSuman<mpz_class>(options);
+    }
+    else {
+        succeeded = runSuman<long long>(options);
+    }
+
+    if (usesMPI(options.backend)) {
+        MPI_Finalize();
+    }
+
+    return succeeded ? 0 : -1;
+}
@@ -13,6 +13,7 @@ from enum import Enum
 TEST_DIR_NAME = "Tests"
 INPUT_FILE_NAME = "suman.in"
 OUTPUT_FILE_NAME = "suman.out"
+QUERIES_FILE_NAME = "suman.queries"
 
 
 def runCommand(cmd):
@@ -33,83 +34,218 @@ def runCommand(cmd):
         sys.exit(-1)
 
 
-commandCompileSequential = "g++ -std=c++17 '{file}.cpp' -o '{file}.exe' -lgmpxx -lgmp && chmod 755 '{file}.exe'"
-commandCompileConcurrent = "g++ --std=c++17 '{file}.cpp' -o '{file}.exe' -pthread -latomic -lgmpxx -lgmp"
-commandCompileMPI = "mpicxx '{file}.cpp' -o '{file}.exe' -lgmpxx -lgmp && chmod 755 '{file}.exe'"
-commandRunSequential = "'{file}.exe' 0"
-commandRunConcurrent = "'{file}.exe' {proc_num} 0"
-commandRunMPI = "mpirun -n {proc_num} '{file}.exe' 0"
+commandCompile = "mpicxx -std=c++17 '{file}.cpp' -o '{file}.exe' -pthread -latomic -lgmpxx -lgmp && chmod 755 '{file}.exe'"
+commandRunSequential = "'{file}.exe' {flags}"
+commandRunConcurrent = "'{file}.exe' --backend threads --threads {proc_num} {flags}"
+commandRunMPI = "mpirun -n {proc_num} '{file}.exe' {flags}"
+commandRunQueries = "'{file}.exe' --backend sequential --number {number} --queries '{queries}'"
+
+DRIVER_FILE_NAME = "suman"
 
 class ExecType(Enum):
     SEQUENTIAL = 0
     CONCURRENT = 1
     MPI = 2
 
-kExecFileName = "kExecFileName"
+# The combinations of the driver's flags which are cross-checked; they used to be separate executables.
+kExecFlags = "kExecFlags"
 kExecType = "kExecType"
 kExecIsBigNumber = "kExecIsBigNumber"
+kExecModulus = "kExecModulus" # optional: the flags ask for the answer modulo this, so it's checked against the others' answer
 executables = [
     {
-        kExecFileName: "suman_sequential",
+        kExecFlags: "--number long --backend sequential",
         kExecType: ExecType.SEQUENTIAL,
         kExecIsBigNumber: False
     },
     {
-        kExecFileName: "suman_sequential_bigNumber",
+        kExecFlags: "--number big --backend sequential",
+        kExecType: ExecType.SEQUENTIAL,
+        kExecIsBigNumber: True
+    },
+    {
+        kExecFlags: "--number crt --backend sequential",
         kExecType: ExecType.SEQUENTIAL,
         kExecIsBigNumber: True
     },
     {
-        kExecFileName: "suman_concurrent_stack",
+        kExecFlags: "--number long --work-list stack",
         kExecType: ExecType.CONCURRENT,
         kExecIsBigNumber: False
     },
     {
-        kExecFileName: "suman_concurrent_stack_bigNumber",
+        kExecFlags: "--number big --work-list stack",
         kExecType: ExecType.CONCURRENT,
         kExecIsBigNumber: True
     },
     {
-        kExecFileName: "suman_concurrent_queue_bigNumber",
+        kExecFlags: "--number big --work-list queue",
         kExecType: ExecType.CONCURRENT,
         kExecIsBigNumber: True
     },
     {
-        kExecFileName: "suman_reduce",
+        kExecFlags: "--number long --backend mpi-static",
         kExecType: ExecType.MPI,
         kExecIsBigNumber: False
     },
     {
-        kExecFileName: "suman_reduce_bigNumber",
+        kExecFlags: "--number big --backend mpi-static",
+        kExecType: ExecType.MPI,
+        kExecIsBigNumber: True
+    },
+    {
+        kExecFlags: "--number crt --backend mpi-static",
         kExecType: ExecType.MPI,
         kExecIsBigNumber: True
     },
     {
-        kExecFileName: "suman_dynamic",
+        kExecFlags: "--number long --backend mpi-dynamic",
         kExecType: ExecType.MPI,
         kExecIsBigNumber: False
     },
     {
-        kExecFileName: "suman_dynamic_bigNumber",
+        kExecFlags: "--number big --backend mpi-dynamic",
         kExecType: ExecType.MPI,
         kExecIsBigNumber: True
     },
 ]
 
+# A kernel of --kernel, under the sequential and the threads backends, with both number types.
+def kernelExecutables(kernel):
+    return [
+        {
+            kExecFlags: f"--number long --backend sequential --kernel {kernel}",
+            kExecType: ExecType.SEQUENTIAL,
+            kExecIsBigNumber: False
+        },
+        {
+            kExecFlags: f"--number big --backend sequential --kernel {kernel}",
+            kExecType: ExecType.SEQUENTIAL,
+            kExecIsBigNumber: True
+        },
+        {
+            kExecFlags: f"--number long --kernel {kernel}",
+            kExecType: ExecType.CONCURRENT,
+            kExecIsBigNumber: False
+        },
+        {
+            kExecFlags: f"--number big --kernel {kernel}",
+            kExecType: ExecType.CONCURRENT,
+            kExecIsBigNumber: True
+        },
+    ]
+
+executables += kernelExecutables("skip")
+executables += kernelExecutables("map")
+executables += kernelExecutables("exp")
+executables += kernelExecutables("wide")
+executables += kernelExecutables("table")
+executables += kernelExecutables("gray")
+executables += kernelExecutables("simd")
+executables += kernelExecutables("prefix")
+executables += kernelExecutables("clique")
+executables += kernelExecutables("mitm")
+executables += kernelExecutables("sieve")
+executables += kernelExecutables("period")
+
+executables += [
+    {
+        kExecFlags: "--number big --backend sequential --arena",
+        kExecType: ExecType.SEQUENTIAL,
+        kExecIsBigNumber: True
+    },
+    {
+        kExecFlags: "--number big --arena",
+        kExecType: ExecType.CONCURRENT,
+        kExecIsBigNumber: True
+    },
+]
 
-def compileExecutables():
-    for executableDict in executables:
-        cwd = os.getcwd()
-        execPath = os.path.join(cwd, executableDict[kExecFileName])
+executables += [
+    {
+        kExecFlags: "--number big --backend sequential --buckets",
+        kExecType: ExecType.SEQUENTIAL,
+        kExecIsBigNumber: True
+    },
+    {
+        kExecFlags: "--number big --buckets",
+        kExecType: ExecType.CONCURRENT,
+        kExecIsBigNumber: True
+    },
+]
 
-        if executableDict[kExecType] == ExecType.SEQUENTIAL:
-            compileCommand = commandCompileSequential.format(file=execPath)
-        elif executableDict[kExecType] == ExecType.CONCURRENT:
-            compileCommand = commandCompileConcurrent.format(file=execPath)
-        else:
-            compileCommand = commandCompileMPI.format(file=execPath)
+# the answer modulo an odd P (one Montgomery lane) and an even one (the exact answer, reduced)
+executables += [
+    {
+        kExecFlags: "--backend sequential --mod 1000000007",
+        kExecType: ExecType.SEQUENTIAL,
+        kExecIsBigNumber: True,
+        kExecModulus: 1000000007
+    },
+    {
+        kExecFlags: "--backend sequential --mod 1000000000000",
+        kExecType: ExecType.SEQUENTIAL,
+        kExecIsBigNumber: True,
+        kExecModulus: 1000000000000
+    },
+    {
+        kExecFlags: "--mod 1000000007",
+        kExecType: ExecType.CONCURRENT,
+        kExecIsBigNumber: True,
+        kExecModulus: 1000000007
+    },
+    {
+        kExecFlags: "--backend mpi-static --mod 1000000007",
+        kExecType: ExecType.MPI,
+        kExecIsBigNumber: True,
+        kExecModulus: 1000000007
+    },
+    {
+        kExecFlags: "--backend mpi-dynamic --mod 1000000000000",
+        kExecType: ExecType.MPI,
+        kExecIsBigNumber: True,
+        kExecModulus: 1000000000000
+    },
+]
 
-        runCommand(compileCommand)
+# --plan picks the number type, the kernel and (unless it's an MPI one) the backend by itself
+executables += [
+    {
+        kExecFlags: "--plan",
+        kExecType: ExecType.SEQUENTIAL,
+        kExecIsBigNumber: True
+    },
+    {
+        kExecFlags: "--plan --backend mpi-dynamic",
+        kExecType: ExecType.MPI,
+        kExecIsBigNumber: True
+    },
+]
+
+# --bonferroni without a tolerance or a time budget runs until its interval is the answer
+executables += [
+    {
+        kExecFlags: "--bonferroni",
+        kExecType: ExecType.SEQUENTIAL,
+        kExecIsBigNumber: True
+    },
+    {
+        kExecFlags: "--bonferroni",
+        kExecType: ExecType.CONCURRENT,
+        kExecIsBigNumber: True
+    },
+    {
+        kExecFlags: "--bonferroni --backend mpi-static",
+        kExecType: ExecType.MPI,
+        kExecIsBigNumber: True
+    },
+]
+
+
+def compileExecutables():
+    cwd = os.getcwd()
+    execPath = os.path.join(cwd, DRIVER_FILE_NAME)
+    runCommand(commandCompile.format(file=execPath))
 
 
 def copyTestContentsToInput(testName):
@@ -123,6 +259,97 @@ def copyTestContentsToInput(testName):
     shutil.copyfile(testPath, inputPath)
 
 
+def answerForN(testName, N):
+    # the answer of the test with its N replaced, from one plain run of the driver
+    if N == 0:
+        return 0
+
+    cwd = os.getcwd()
+    testPath = os.path.join(cwd, TEST_DIR_NAME, testName)
+    inputPath = os.path.join(cwd, INPUT_FILE_NAME)
+
+    header, rest = open(testPath).read().split("\n", 1)
+    header = header.split()
+    header[0] = str(N)
+    with open(inputPath, "w") as inputFile:
+        inputFile.write(" ".join(header) + "\n" + rest)
+
+    runCommand(commandRunSequential.format(file=os.path.join(cwd, DRIVER_FILE_NAME), flags="--number big --backend sequential"))
+    return int(open(os.path.join(cwd, OUTPUT_FILE_NAME)).read().strip())
+
+
+def checkQueries(i, testName, testIsBigNumber):
+    # --queries answers many N and intervals [A, B] at once; every line must be f(B) - f(A - 1),
+    # with f taken from a separate run of the driver for each N
+    cwd = os.getcwd()
+    queriesPath = os.path.join(cwd, QUERIES_FILE_NAME)
+
+    N = int(open(os.path.join(cwd, TEST_DIR_NAME, testName)).read().split()[0])
+    intervals = [(1, N), (1, N // 2), (1, 1), (1, N), (N // 3 + 2, N), (2, N // 2), (N // 2 + 1, N // 2), (1, 0)]
+    lines = [f"{N}", f"{N // 2}", "1", f"1 {N}", f"{N // 3 + 2} {N}", f"2 {N // 2}", f"{N // 2 + 1} {N // 2}", "1 0"]
+
+    values = {}
+    for (low, high) in intervals:
+        for point in [low - 1, high]:
+            if point not in values:
+                values[point] = answerForN(testName, point)
+    copyTestContentsToInput(testName)
+
+    with open(queriesPath, "w") as queriesFile:
+        queriesFile.write("\n".join(lines) + "\n")
+
+    numberTypes = ["big"] if testIsBigNumber else ["big", "long"]
+    for number in numberTypes:
+        runCommand(commandRunQueries.format(file=os.path.join(cwd, DRIVER_FILE_NAME), number=number, queries=queriesPath))
+        answers = open(os.path.join(cwd, OUTPUT_FILE_NAME)).read().split()
+        expected = [str(values[high] - values[low - 1]) for (low, high) in intervals]
+        if answers != expected:
+            print(f"--queries with --number {number} found {answers} instead of {expected} for the queries {lines}")
+            print(f"📙 Test #{i} ({testName}) failed! ")
+            sys.exit(-1)
+
+    os.remove(queriesPath)
+    print(f"📗 Test #{i} ({testName}) succeeded on the queries! ")
+    print()
+
+
+def checkWideSplit():
+    # 62 primes just above 2 * 10^6 and N = 10^12: a range of 2^62 masks, which the static MPI split
+    # has to divide between an odd number of processes as well without overflowing. Only the kernels
+    # which skip the masks over N can get through it, so it isn't in TEST_DIR_NAME with the others.
+    primes = []
+    candidate = 2000001
+    while len(primes) < 62:
+        if all(candidate % d != 0 for d in range(2, int(candidate ** 0.5) + 1)):
+            primes.append(candidate)
+        candidate += 1
+
+    cwd = os.getcwd()
+    executablePath = os.path.join(cwd, DRIVER_FILE_NAME)
+    with open(os.path.join(cwd, INPUT_FILE_NAME), "w") as inputFile:
+        inputFile.write(f"1000000000000 {len(primes)}\n" + "\n".join(map(str, primes)) + "\n")
+
+    print("🟡🟡🟡🟡 Running the 62-divisor split check! 🟡🟡🟡🟡")
+    commands = [commandRunSequential.format(file=executablePath, flags="--number big --backend sequential")]
+    for processNumber in [3, 4, 8]:
+        commands.append(commandRunMPI.format(file=executablePath, proc_num=processNumber, flags="--number big --backend mpi-static"))
+    commands.append(commandRunMPI.format(file=executablePath, proc_num=3, flags="--number big --backend mpi-dynamic"))
+    commands.append(commandRunConcurrent.format(file=executablePath, proc_num=3, flags="--number big"))
+
+    results = set()
+    for command in commands:
+        runCommand(command)
+        curr_result = str(open(os.path.join(cwd, OUTPUT_FILE_NAME)).read()).strip()
+        if len(results) == 1 and curr_result not in results:
+            print(f"Command ({command}) found a different result({curr_result}) than the current one({list(results)[0]})")
+            print(f"📙 The 62-divisor split check failed! ")
+            sys.exit(-1)
+        results.add(curr_result)
+
+    print(f"📗 The 62-divisor split check succeeded with result '{results.pop()}'! ")
+    print()
+
+
 def runTests():
     cwd = os.getcwd()
     testsDir = os.path.join(cwd, TEST_DIR_NAME)
@@ -153,9 +380,9 @@ def runTests():
                     continue
 
             results = set()
+            residueResults = []
+            executablePath = os.path.join(cwd, DRIVER_FILE_NAME)
             for executableDict in executables:
-                executablePath = os.path.join(cwd, executableDict[kExecFileName])
-
                 executableIsBigNumber = executableDict[kExecIsBigNumber]
                 if testIsBigNumber and not executableIsBigNumber:
                     continue
@@ -171,21 +398,35 @@ def runTests():
                     cmd = commandRunMPI
 
                 for processNumber in procNumList:
-                    modified_cmd = cmd.format(file=executablePath, proc_num=processNumber)
+                    modified_cmd = cmd.format(file=executablePath, proc_num=processNumber, flags=executableDict[kExecFlags])
                     runCommand(modified_cmd)
 
                     curr_result = str(open(output_file).read()).strip()
 
+                    if kExecModulus in executableDict:
+                        residueResults.append((executableDict[kExecFlags], executableDict[kExecModulus], curr_result))
+                        continue
+
                     if len(results) == 1 and curr_result not in results:
-                        print(f"Exec {executablePath} found a different result({curr_result}) than the current one({list(results)[0]})")
+                        print(f"Exec {executablePath} {executableDict[kExecFlags]} found a different result({curr_result}) than the current one({list(results)[0]})")
                         print(f"📙 Test #{i} ({testName}) failed! ")
                         sys.exit(-1)
                     results.add(curr_result)
 
             if len(results) == 1:
+                answer = int(next(iter(results)))
+                for (flags, modulus, residue) in residueResults:
+                    if residue != str(answer % modulus):
+                        print(f"Exec {executablePath} {flags} found a different result({residue}) than the answer modulo {modulus}({answer % modulus})")
+                        print(f"📙 Test #{i} ({testName}) failed! ")
+                        sys.exit(-1)
+
                 print(f"📗 Test #{i} ({testName}) succeeded with result '{results.pop()}'! ")
                 print()
                 print()
+
+                if c == 0:
+                    checkQueries(i, testName, testIsBigNumber)
             else:
                 print(f"Multiple results: {results}")
                 print(f"📙 Test #{i} ({testName}) failed! ")
@@ -221,4 +462,6 @@ if __name__ == "__main__":
 
     compileExecutables(); print()
     runTests()
+    if args.test_name is None and args.big != 0:
+        checkWideSplit()
 